@@ -8,18 +8,106 @@
 #define DORMANT     0 //state of terminated task
 #define READY       1 //state of task that can be scheduled but is not running
 #define RUNNING     2 //state of running task
-#define SLEEPING    3 //state of sleeping task
+#define SLEEPING    3 //state of sleeping task, or of one throttled for overrunning its budget
+#define BLOCKED     4 //state of task waiting on a kernel object
+#define ZOMBIE      5 //state of exited task whose slot and stack await osTaskJoin() or osTaskDetach()
 
-#define RTX_OK  0
-#define RTX_ERR 1
+#define RTX_OK      0
+#define RTX_ERR     1
+#define RTX_TIMEOUT 2 //blocking call gave up before it could complete
+
+#define OS_WAIT_FOREVER 0xFFFFFFFF //timeout for blocking calls that never expires
+#define MAX_SEMAPHORES  16 //maximum number of semaphores in the system
+#define MAX_MUTEXES     16 //maximum number of mutexes in the system
+#define MAX_FUTEXES     16 //maximum number of contended addresses at once
+#define MAX_CONDVARS    16 //maximum number of condition variables in the system
+#define MAX_RWLOCKS     8  //maximum number of readers-writer locks in the system
+#define MAX_BARRIERS    8  //maximum number of barriers in the system
+#define MAX_GROUPS      4  //maximum number of task groups in the system
+#define GROUP_NONE      0xFFFFFFFF //group of a task that is in no group
+#define MAX_WORKQUEUES  2  //maximum number of work queues in the system
+#define WORKQ_DEPTH     16 //maximum number of jobs pending on one work queue
+#define MAX_RTC_HANDLERS 128 //maximum number of run-to-completion handlers in the system
+#define RTC_STACK_SIZE  0x400 //stack shared by all run-to-completion handlers
+#define MAX_QUEUES      8  //maximum number of message queues in the system
+#define MAX_EVENTS      8  //maximum number of event flag groups in the system
+#define MAX_TOPICS      8  //maximum number of pub/sub topics in the system
+#define MAX_SUBSCRIPTIONS 16 //maximum number of topic subscriptions in the system
+
+#define EVENT_WAIT_ANY  0 //wake when any flag in the mask is set
+#define EVENT_WAIT_ALL  1 //wake when every flag in the mask is set
+#define EVENT_CLEAR     2 //or'd into the mode: consume the flags that woke the waiter
 
 #define MAIN_STACK_SIZE     0x400
 #define THREAD_STACK_SIZE   0x400
+#define STACK_PAINT         0xDEADBEEF //fill of task stack words never written
+#define STACK_MARGIN        25 //headroom in percent osStackReport() adds to measured use
+
+#ifndef ADMISSION_CONTROL
+#define ADMISSION_CONTROL   0 //1 to reject task sets EDF can't schedule, from wcet_ms and period (cycle budgets rounded up to ms)
+#endif
+#define ADMISSION_HORIZON   10000 //longest interval (ms) the processor-demand test checks
+
+#ifndef SCHED_FIXED_PRIORITY
+#define SCHED_FIXED_PRIORITY 0 //1 to schedule by fixed priority instead of EDF
+#endif
+#define FP_LEVELS           32 //number of fixed priority levels, 0 is the highest
+#define FP_AUTO             0xFF //priority taken from the task's rate-monotonic rank
+
+#define SCHED_REALTIME      0 //scheduled by deadline (or priority), the default
+#define SCHED_BACKGROUND    1 //round-robin, only when no real-time task is ready
+#ifndef RR_TIMESLICE
+#define RR_TIMESLICE        10 //ms a background task runs before the next one gets a turn
+#endif
+#define BACKGROUND_KEY      (0xFFFFFFFF - 1) //scheduling key of background tasks, after all real-time ones
 
 typedef unsigned int U32;
 typedef unsigned short U16;
 typedef char U8;
 typedef unsigned int task_t;
+typedef unsigned int semaphore_t;
+typedef unsigned int mutex_t;
+typedef unsigned int cond_t;
+typedef unsigned int barrier_t;
+typedef unsigned int group_t;
+typedef unsigned int workq_t;
+typedef unsigned int rtc_t;
+typedef unsigned int queue_t;
+typedef unsigned int event_t;
+typedef unsigned int topic_t;
+typedef unsigned int subscription_t;
+
+struct waitQueue;
+
+typedef struct ipcMsg {
+    const void *msg;    //request sent to the server
+    U32     msg_len;    //request length in bytes
+    void    *reply;     //buffer for the server's reply
+    U32     reply_len;  //size of reply, set to the bytes actually replied
+} ipcMsg;
+
+typedef struct fastMutex {
+    volatile U32 state; //FAST_MUTEX_UNLOCKED, _LOCKED or _CONTENDED
+} fastMutex;
+
+#define FAST_MUTEX_UNLOCKED  0
+#define FAST_MUTEX_LOCKED    1 //locked, nobody waiting, unlock needs no SVC
+#define FAST_MUTEX_CONTENDED 2 //locked, and some task may be blocked in the kernel
+
+typedef struct workJob {
+    void (*fn)(void *arg); //function a worker calls
+    void *arg;             //argument passed to fn
+    U32 deadline;          //ms from submission the job must finish by, 0 for DEFAULT_DEADLINE
+} workJob;
+
+typedef struct rwLock {
+    volatile U32 state; //reader count and RWLOCK_ flags
+    U32 id;             //kernel-side wait queues, set by osRwLockCreate()
+} rwLock;
+
+#define RWLOCK_READERS 0x0000FFFF //number of tasks holding the lock for reading
+#define RWLOCK_WRITER  0x40000000 //held by a writer
+#define RWLOCK_WAITING 0x80000000 //some task may be blocked in the kernel, releases need an SVC
 
 
 typedef struct task_control_block {
@@ -31,6 +119,8 @@ typedef struct task_control_block {
     U32     stackptr;               //stack top address
     U32     deadline;               //configured deadline (ms)
     U32     time_left;              //time left in to deadline (ms)
+    U32     wcet_ms;                //declared worst-case execution time per period (ms), 0 if undeclared
+    U32     period;                 //declared minimum time between releases (ms), 0 if equal to the deadline
 } TCB;
 
 // Multithreading functions
@@ -38,11 +128,70 @@ void osKernelInit(void);
 int osCreateTask(TCB *task);
 int osKernelStart(void);
 void osYield(void);
+int osYieldTo(task_t tid);
 int osTaskInfo(task_t tid, TCB* task_copy);
 task_t osGetTID(void);
 int osTaskExit(void);
+int osTaskExitCode(int status);
+int osTaskJoin(task_t tid, int *status, U32 timeout);
+int osTaskDetach(task_t tid);
+int osStackUsage(task_t tid, U32 *used);
+void osStackReport(U8 recommend);
+int osGroupCreate(group_t *group);
+int osGroupSpawn(group_t group, TCB *task);
+int osGroupWait(group_t group, U32 timeout);
+int osGroupKill(group_t group);
+int osWorkqCreate(workq_t *wq, U32 workers, U16 stack_size);
+int osWorkqSubmit(workq_t wq, const workJob *jobs, U32 count);
+int osRtcCreate(rtc_t *handler, void (*fn)(void *arg), void *arg, U32 deadline);
+int osRtcPost(rtc_t handler);
 
 // pre-emptive multitasking functions
 int osSetDeadline(int deadline, task_t TID);
+int osSetReservation(task_t tid, U32 budget, U32 period); //budget and period in ms
+int osSetBudget(task_t tid, U32 wcet, int (*on_overrun)(task_t tid)); //wcet in CPU cycles
+int osSetPriority(task_t tid, U32 priority);
+int osSetClass(task_t tid, U32 cls);
+
+// Synchronization functions
+int osSemCreate(semaphore_t *sem, U32 count);
+int osSemWait(semaphore_t sem, U32 timeout);
+int osSemPost(semaphore_t sem);
+int osMutexCreate(mutex_t *mutex);
+int osMutexLock(mutex_t mutex, U32 timeout);
+int osMutexUnlock(mutex_t mutex);
+int osFutexWait(volatile U32 *addr, U32 expected, U32 timeout);
+int osFutexWake(volatile U32 *addr, U32 count);
+void osFastMutexInit(fastMutex *mutex);
+int osFastMutexLock(fastMutex *mutex, U32 timeout);
+int osFastMutexUnlock(fastMutex *mutex);
+int osRwLockCreate(rwLock *lock);
+int osRwLockRead(rwLock *lock, U32 timeout);
+int osRwLockWrite(rwLock *lock, U32 timeout);
+int osRwLockUnlock(rwLock *lock);
+int osBarrierCreate(barrier_t *barrier, U32 parties);
+int osBarrierWait(barrier_t barrier, U32 timeout);
+int osCondCreate(cond_t *cond);
+int osCondWait(cond_t cond, mutex_t mutex, U32 timeout);
+int osCondSignal(cond_t cond);
+int osCondBroadcast(cond_t cond);
+int osEventCreate(event_t *event);
+int osEventSet(event_t event, U32 mask);
+int osEventClear(event_t event, U32 mask);
+int osEventWait(event_t event, U32 mask, U32 mode, U32 timeout);
+
+// Message passing functions
+int osQueueCreate(queue_t *queue, U32 capacity);
+int osQueueSend(queue_t queue, U32 msg, U32 timeout);
+int osQueueSendBlock(queue_t queue, void *block, U32 timeout);
+int osQueueReceive(queue_t queue, U32 *msg, U32 timeout);
+int osSend(task_t server, ipcMsg *msg);
+int osReceive(task_t *client, void *buf, U32 len, U32 timeout);
+int osReply(task_t client, const void *reply, U32 len);
+int osTopicCreate(topic_t *topic, U32 size);
+int osSubscribe(topic_t topic, U32 depth, subscription_t *sub);
+int osPublish(topic_t topic, const void *data);
+int osTopicRead(topic_t topic, void *buf);
+int osTopicReceive(subscription_t sub, void *buf, U32 timeout);
 
 #endif /* INC_COMMON_H_ */
@@ -0,0 +1,44 @@
+/*
+ * k_atomic.h
+ *
+ *  Word-sized LDREX/STREX primitives shared by the thread-mode lock fast
+ *  paths. They never enter the kernel.
+ */
+
+#ifndef INC_K_ATOMIC_H_
+#define INC_K_ATOMIC_H_
+
+#include "common.h"
+#include "stm32f401xe.h"
+
+/**
+ * @brief Atomically replace *addr with desired if it holds expected
+ * 
+ * @retval Value of *addr before the attempt
+ */
+static inline U32 compareExchange(volatile U32 *addr, U32 expected, U32 desired) {
+    U32 old;
+    do {
+        old = __LDREXW(addr);
+        if (old != expected) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(desired, addr) != 0);
+    return old;
+}
+
+/**
+ * @brief Atomically store value in *addr
+ * 
+ * @retval Value of *addr before the store
+ */
+static inline U32 exchange(volatile U32 *addr, U32 value) {
+    U32 old;
+    do {
+        old = __LDREXW(addr);
+    } while (__STREXW(value, addr) != 0);
+    return old;
+}
+
+#endif /* INC_K_ATOMIC_H_ */
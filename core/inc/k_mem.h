@@ -17,22 +17,65 @@ typedef struct metaHeader {
     size_t size; // the size of the block
     struct metaHeader * next; // the next free block in memory
     U8 tid; // owner of the block in memory, null if free
-    U8 is_allocated; // 1 if allocated, 0 if free
+    U8 is_allocated; // BLOCK_FREE, BLOCK_ALLOCATED or BLOCK_MOVABLE
+    union {
+        U16 handle; // index into the handle table for movable blocks
+        volatile U16 refs; // outstanding references to a shared block
+    };
 } metaHeader;
 #define METADATA_SIZE sizeof(metaHeader)
 
+#define BLOCK_FREE      0 // block is on the freelist
+#define BLOCK_ALLOCATED 1 // block is pinned at its address until freed
+#define BLOCK_MOVABLE   2 // block is only reachable through a handle
+#define BLOCK_SHARED    3 // block is reference counted and freed by its last holder
+
+#define MAX_HANDLES 32 // maximum number of live movable allocations
+
+typedef unsigned int mem_handle_t;
+
 extern struct metaHeader *freelist_head;
 
+typedef struct memStats {
+    size_t heap_size; // bytes managed by the allocator at init
+    size_t bytes_allocated; // payload bytes in allocated blocks
+    U32 blocks_allocated; // number of allocated blocks
+    size_t bytes_free; // payload bytes in free blocks
+    U32 blocks_free; // number of free blocks
+    size_t largest_free; // largest request that can currently succeed
+} memStats;
+
 // User-side functions
 int k_mem_init();
 void * k_mem_alloc(size_t size);
 int k_mem_dealloc(void * ptr);
 int k_mem_count_extfrag(size_t size);
+int k_mem_stats(memStats *stats);
+int k_mem_alloc_movable(size_t size, mem_handle_t *handle);
+void * k_mem_lock(mem_handle_t handle);
+int k_mem_unlock(mem_handle_t handle);
+int k_mem_dealloc_movable(mem_handle_t handle);
+int k_mem_compact(void);
+int k_mem_transfer(void *ptr, task_t tid);
+void * k_mem_alloc_shared(size_t size);
+int k_mem_retain(void *ptr);
+int k_mem_release(void *ptr);
 
 // Kernel-side functions
 int mem_init();
 void * mem_alloc(size_t size);
 int mem_dealloc(void * ptr);
+int mem_dealloc_owned(void *ptr, task_t owner);
+size_t mem_size(void *ptr);
 int mem_count_extfrag(size_t size);
+int mem_stats(memStats *stats);
+int mem_alloc_movable(size_t size, mem_handle_t *handle);
+void * mem_lock(mem_handle_t handle);
+int mem_unlock(mem_handle_t handle);
+int mem_dealloc_movable(mem_handle_t handle);
+int mem_compact(void);
+int mem_transfer(void *ptr, task_t from, task_t to);
+void * mem_alloc_shared(size_t size);
+int mem_dealloc_shared(void *ptr);
 
 #endif /* INC_K_MEM_H_ */
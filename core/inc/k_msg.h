@@ -0,0 +1,64 @@
+/*
+ * k_msg.h
+ *
+ *  Kernel-side message passing between tasks.
+ */
+
+#ifndef INC_K_MSG_H_
+#define INC_K_MSG_H_
+
+#include "common.h"
+#include "k_task.h"
+#include "k_seqlock.h"
+
+typedef struct queueSlot {
+    U32 msg; // message word, or address of a k_mem block
+    U32 is_block; // 1 if msg is a block whose ownership moves with it
+} queueSlot;
+
+typedef struct msgQueue {
+    U8 in_use; // 1 once handed out by queueCreate()
+    U32 capacity; // number of slots
+    U32 count; // slots currently holding a message
+    U32 head; // index of the oldest message
+    queueSlot *slots; // ring of capacity slots, allocated from k_mem
+    waitQueue senders; // tasks blocked in queueSend() on a full queue
+    waitQueue receivers; // tasks blocked in queueReceive() on an empty queue
+} msgQueue;
+
+typedef struct topic {
+    U8 in_use; // 1 once handed out by topicCreate()
+    U32 size; // bytes per sample
+    seqlock lock; // guards latest, its count is the topic's publish sequence
+    U8 *latest; // most recent sample, from k_mem
+    waitQueue waiters; // subscribers blocked in topicReceive()
+} topic;
+
+typedef struct subscription {
+    U8 in_use; // 1 once handed out by subscribe()
+    topic_t topic; // topic subscribed to
+    U32 depth; // queued samples kept, 0 for latest-value mode
+    U32 count; // samples currently queued
+    U32 head; // index of the oldest queued sample
+    U32 last_seq; // topic lock.seq of the last sample received, latest-value mode
+    U32 dropped; // samples overwritten because the queue was full
+    U8 *samples; // ring of depth samples, from k_mem
+} subscription;
+
+extern topic topics[MAX_TOPICS];
+
+// Kernel-side functions
+int queueCreate(queue_t *queue, U32 capacity);
+int queueSend(queue_t queue, U32 msg, U32 timeout, U32 is_block);
+int queueReceive(queue_t queue, U32 *msg, U32 timeout);
+
+int ipcSend(task_t server, ipcMsg *msg);
+int ipcReceive(task_t *client, void *buf, U32 len, U32 timeout);
+int ipcReply(task_t client, const void *reply, U32 len);
+
+int topicCreate(topic_t *topic, U32 size);
+int subscribe(topic_t topic, U32 depth, subscription_t *sub);
+int publish(topic_t topic, const void *data);
+int topicReceive(subscription_t sub, void *buf, U32 timeout);
+
+#endif /* INC_K_MSG_H_ */
@@ -0,0 +1,32 @@
+/*
+ * k_ring.h
+ *
+ *  Lock-free single-producer/single-consumer byte ring for handing data
+ *  from an ISR to a task. Only the consumer's blocking wait enters the
+ *  kernel.
+ */
+
+#ifndef INC_K_RING_H_
+#define INC_K_RING_H_
+
+#include "common.h"
+#include "k_task.h"
+
+typedef struct ringBuffer {
+    volatile U32 head; // free-running write count, only advanced by the producer
+    volatile U32 tail; // free-running read count, only advanced by the consumer
+    U32 mask; // capacity - 1, capacity is a power of two
+    U8 *data; // caller-provided storage of capacity bytes
+    waitQueue waiters; // consumer blocked in ringWait()
+} ringBuffer;
+
+// User-side functions
+int osRingInit(ringBuffer *ring, U8 *storage, U32 capacity);
+int osRingPut(ringBuffer *ring, U8 byte);
+int osRingGet(ringBuffer *ring, U8 *byte);
+int osRingWait(ringBuffer *ring, U32 timeout);
+
+// Kernel-side functions
+int ringWait(ringBuffer *ring, U32 timeout);
+
+#endif /* INC_K_RING_H_ */
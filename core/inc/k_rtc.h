@@ -0,0 +1,33 @@
+/*
+ * k_rtc.h
+ *
+ *  Run-to-completion handlers: light event handlers that never block,
+ *  all run one at a time by a single dispatcher task on its one stack,
+ *  in EDF order of their activation deadlines.
+ */
+
+#ifndef INC_K_RTC_H_
+#define INC_K_RTC_H_
+
+#include "common.h"
+#include "k_task.h"
+
+typedef struct rtcHandler {
+    void (*fn)(void *arg); // handler body, must return without blocking
+    void *arg; // argument passed to fn
+    U32 deadline; // ms from activation the handler must finish by
+    U32 due; // HAL tick by which the pending activation should be done
+    U8 in_use; // 1 once handed out by rtcCreate()
+    U8 pending; // 1 while activated and not yet dispatched
+    struct rtcHandler *next; // next pending handler, earliest due first
+} rtcHandler;
+
+// User-side functions
+int osRtcNext(workJob *job);
+
+// Kernel-side functions
+int rtcCreate(rtc_t *handler, void (*fn)(void *arg), void *arg, U32 deadline);
+int rtcPost(rtc_t handler);
+int rtcNext(workJob *job);
+
+#endif /* INC_K_RTC_H_ */
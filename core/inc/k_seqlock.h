@@ -0,0 +1,43 @@
+/*
+ * k_seqlock.h
+ *
+ *  Lock-free primitives for state written by one producer (often an ISR)
+ *  and read by tasks. Writers never block; readers either retry (seqlock)
+ *  or swap buffers (triple buffer). Neither enters the kernel.
+ */
+
+#ifndef INC_K_SEQLOCK_H_
+#define INC_K_SEQLOCK_H_
+
+#include "common.h"
+
+typedef struct seqlock {
+    volatile U32 seq; // even while stable, odd while a write is in progress
+} seqlock;
+
+typedef struct tripleBuffer {
+    U8 *data; // caller-provided storage for three buffers of size bytes
+    U32 size; // bytes per buffer
+    volatile U32 state; // index of the latest published buffer, plus TRIPLE_FRESH
+    U32 back; // buffer the writer fills next, owned by the writer
+    U32 front; // buffer the reader last took, owned by the reader
+} tripleBuffer;
+
+#define TRIPLE_INDEX 0x3 // state bits holding the latest buffer's index
+#define TRIPLE_FRESH 0x4 // state bit set until the reader takes the latest buffer
+
+// User-side functions
+void osSeqlockInit(seqlock *lock);
+void osSeqlockWriteBegin(seqlock *lock);
+void osSeqlockWriteEnd(seqlock *lock);
+U32 osSeqlockReadBegin(seqlock *lock);
+int osSeqlockReadRetry(seqlock *lock, U32 start);
+void osSeqlockWrite(seqlock *lock, void *dst, const void *src, U32 size);
+U32 osSeqlockRead(seqlock *lock, void *dst, const void *src, U32 size);
+
+int osTripleInit(tripleBuffer *buffer, U8 *storage, U32 size);
+void * osTripleWriteBuffer(tripleBuffer *buffer);
+void osTriplePublish(tripleBuffer *buffer);
+void * osTripleRead(tripleBuffer *buffer, int *fresh);
+
+#endif /* INC_K_SEQLOCK_H_ */
@@ -0,0 +1,88 @@
+/*
+ * k_sync.h
+ *
+ *  Kernel-side synchronization objects. Tasks block on these through the
+ *  wait queues in k_task.c, so waiters are always woken in deadline order.
+ */
+
+#ifndef INC_K_SYNC_H_
+#define INC_K_SYNC_H_
+
+#include "common.h"
+#include "k_task.h"
+
+typedef struct semaphore {
+    U8 in_use; // 1 once handed out by semCreate()
+    U32 count; // available units, only non-zero while nobody waits
+    waitQueue waiters; // tasks blocked in semWait()
+} semaphore;
+
+typedef struct mutex {
+    U8 in_use; // 1 once handed out by mutexCreate()
+    task_t owner; // holding task, TID_NULL if unlocked
+    U32 lock_count; // recursive lock depth of the owner
+    waitQueue waiters; // tasks blocked in mutexLock()
+} mutex;
+
+typedef struct futex {
+    volatile U32 *addr; // user word the waiters are parked on
+    waitQueue waiters; // free for reuse whenever empty
+} futex;
+
+typedef struct eventGroup {
+    U8 in_use; // 1 once handed out by eventCreate()
+    U32 flags; // currently set flags
+    waitQueue waiters; // tasks blocked in eventWait()
+} eventGroup;
+
+typedef struct condVar {
+    U8 in_use; // 1 once handed out by condCreate()
+    waitQueue waiters; // tasks blocked in condWait()
+} condVar;
+
+typedef struct rwLockWaiters {
+    volatile U32 *state; // user word of the lock, NULL while free
+    waitQueue readers; // tasks blocked in rwLockRead()
+    waitQueue writers; // tasks blocked in rwLockWrite()
+} rwLockWaiters;
+
+typedef struct barrier {
+    U8 in_use; // 1 once handed out by barrierCreate()
+    U32 parties; // number of tasks that must arrive to release the barrier
+    U32 arrived; // tasks blocked in barrierWait() for the current round
+    waitQueue waiters; // tasks blocked in barrierWait()
+} barrier;
+
+// Kernel-side functions
+int semCreate(semaphore_t *sem, U32 count);
+int semWait(semaphore_t sem, U32 timeout);
+int semPost(semaphore_t sem);
+
+int mutexCreate(mutex_t *mutex);
+int mutexLock(mutex_t mutex, U32 timeout);
+int mutexUnlock(mutex_t mutex);
+
+int futexWait(volatile U32 *addr, U32 expected, U32 timeout);
+int futexWake(volatile U32 *addr, U32 count);
+
+int eventCreate(event_t *event);
+int eventSet(event_t event, U32 mask);
+int eventClear(event_t event, U32 mask);
+int eventWait(event_t event, U32 mask, U32 mode, U32 timeout);
+
+int condCreate(cond_t *cond);
+int condWait(cond_t cond, mutex_t mutex, U32 timeout);
+int condSignal(cond_t cond);
+int condBroadcast(cond_t cond);
+
+int rwLockCreate(rwLock *lock);
+int rwLockRead(U32 id, U32 timeout);
+int rwLockWrite(U32 id, U32 timeout);
+int rwLockUnlock(U32 id);
+
+int barrierCreate(barrier_t *b, U32 parties);
+int barrierWait(barrier_t b, U32 timeout);
+
+void waitAborted(waitQueue *queue);
+
+#endif /* INC_K_SYNC_H_ */
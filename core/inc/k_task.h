@@ -14,16 +14,79 @@
 
 #define DEFAULT_DEADLINE 5 //ms
 
+typedef struct waitQueue {
+    TCB *head; // blocked tasks, earliest deadline first
+} waitQueue;
+
+typedef struct kernelTCB {
+    U32 inherit_left; // time left of the most urgent task blocked on a mutex we hold, 0 if none
+    U32 donated_left; // time left of the most urgent client waiting on us in osSend(), 0 if none
+    TCB *wait_next; // next task blocked on the same queue
+    waitQueue *wait_queue; // queue the task is blocked on, if any
+    U32 wait_timeout; // time left before a blocking call gives up (ms)
+    U32 *wait_frame; // exception frame of the blocked SVC, for its args and retval
+    U32 wait_info; // object-specific detail of the blocked call
+} kernelTCB;
+
+typedef struct taskGroup {
+    U8 in_use; // 1 once handed out by groupCreate()
+    U32 members; // bitmask of member TIDs
+    waitQueue waiters; // tasks blocked in groupWait()
+} taskGroup;
+
+typedef struct reservation {
+    U32 budget; // CPU time Q the task may use per period (ms), 0 if not reserved
+    U32 period; // reservation period P (ms)
+    U32 left; // budget left before the server deadline is postponed (ms)
+    U32 due; // HAL tick of the current server deadline
+} reservation;
+
+typedef struct execBudget {
+    U32 wcet; // CPU cycles the task may use per deadline period, 0 if unlimited
+    U32 used; // cycles used so far in the current period
+    U8 throttled; // 1 while held off until its next period for overrunning
+    int (*on_overrun)(task_t tid); // called on overrun, RTX_OK lets the task go on
+} execBudget;
+
 void kernelInit(void);
 int createTask(TCB *task);
 int startKernel(void);
 int taskInfo(task_t tid, TCB* task_copy);
 task_t getTID(void);
 void yield(void);
+int yieldTo(task_t tid);
 void scheduler(void);
 int taskExit(void);
+int taskExitCode(int status);
+int taskJoin(task_t tid, int *status, U32 timeout);
+int taskDetach(task_t tid);
+int stackUsage(task_t tid, U32 *used);
+int setReservation(task_t tid, U32 budget, U32 period);
+int setBudget(task_t tid, U32 wcet, int (*on_overrun)(task_t tid));
+int setPriority(task_t tid, U32 priority);
+int setClass(task_t tid, U32 cls);
+void deadlineTick(void);
+int groupCreate(group_t *group);
+int groupSpawn(group_t group, TCB *task);
+int groupWait(group_t group, U32 timeout);
+int groupKill(group_t group);
 void change_task(void);
 
 int setDeadline(int deadline, task_t TID);
+void retimeTask(task_t tid, U32 deadline, U32 time_left);
+
+// Blocking support for kernel objects
+U32 taskKey(task_t tid);
+void keyChanged(task_t tid);
+int blockTask(waitQueue *queue, U32 timeout);
+int parkTask(waitQueue *queue, U32 timeout);
+void handoffTask(task_t tid, U32 minimum);
+void wakeTask(task_t tid, int ret);
+task_t wakeFirst(waitQueue *queue, int ret);
+void requeueTask(task_t tid);
+void moveWaiter(task_t tid, waitQueue *queue, U32 timeout);
+void preemptIfEarlier(task_t tid);
+void timeoutTick(void);
+void reschedule(void);
 
 #endif /* INC_K_TASK_H_ */
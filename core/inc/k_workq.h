@@ -0,0 +1,35 @@
+/*
+ * k_workq.h
+ *
+ *  Work queues: jobs (function + argument) run on a fixed pool of worker
+ *  tasks created up front, so a job costs no stack allocation or frame
+ *  setup. Each job carries its own deadline, which its worker runs under.
+ */
+
+#ifndef INC_K_WORKQ_H_
+#define INC_K_WORKQ_H_
+
+#include "common.h"
+#include "k_task.h"
+
+typedef struct pendingJob {
+    workJob job; // as submitted
+    U32 due; // HAL tick by which the job should be done
+} pendingJob;
+
+typedef struct workQueue {
+    U8 in_use; // 1 once handed out by workqCreate()
+    U32 count; // number of pending jobs
+    pendingJob pending[WORKQ_DEPTH]; // earliest due first, FIFO among equals
+    waitQueue idle; // workers blocked in workqNext()
+} workQueue;
+
+// User-side functions
+int osWorkqNext(workJob *job);
+
+// Kernel-side functions
+int workqCreate(workq_t *wq, U32 workers, U16 stack_size);
+int workqSubmit(workq_t wq, const workJob *jobs, U32 count);
+int workqNext(workJob *job);
+
+#endif /* INC_K_WORKQ_H_ */
@@ -1,6 +1,13 @@
 #include <stdio.h>
 #include "common.h"
 #include "k_task.h"
+#include "k_mem.h"
+#include "k_ring.h"
+#include "k_sync.h"
+#include "k_atomic.h"
+#include "k_workq.h"
+#include "k_rtc.h"
+#include "stm32f401xe.h"
 
 /**
  * @brief Call SVC to init kernel
@@ -21,14 +28,14 @@ int osCreateTask(TCB *task) {
     return RTX_ERR;
   }
 
-  int ret;
-  __asm(
-    "SVC #1\n"
-    // Copy r0 to return var
-    "MOV %[out], r0\n"
-    : [out] "=r" (ret)
+  register U32 r0 __asm("r0") = (U32)task;
+  __asm volatile(
+      "SVC #1\n"
+      : "+r" (r0)
+      :
+      : "memory"
   );
-  return ret;
+  return (int)r0;
 }
 
 /**
@@ -56,6 +63,22 @@ void osYield(void) {
   __asm("SVC #3");
 }
 
+/**
+ * @brief Call SVC to hand the rest of the current slot to a ready task
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osYieldTo(task_t tid) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  __asm volatile(
+      "SVC #40\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
 /**
  * @brief Call SVC to get task info
  * 
@@ -67,15 +90,65 @@ int osTaskInfo(task_t tid, TCB* task_copy) {
     return RTX_ERR;
   }
 
-  int ret;
-  __asm(
-    "SVC #4\n"
-    // Copy r0 to return var
-    "MOV %[out], r0\n"
-    : [out] "=r" (ret)
-    : "r" (tid), "r" (task_copy)
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = (U32)task_copy;
+  __asm volatile(
+      "SVC #4\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
   );
-  return ret;
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to get the most stack a task has ever used, in bytes
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osStackUsage(task_t tid, U32 *used) {
+  if (used == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = (U32)used;
+  __asm volatile(
+      "SVC #68\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Print the stack high-water mark of every task over the UART
+ *
+ * With recommend set, also prints a stack_size for each task: its
+ * high-water mark plus STACK_MARGIN percent, rounded up to a multiple of 8
+ * and no less than STACK_SIZE. Measure after the tasks have been through
+ * their worst-case paths.
+ * 
+ * @retval None
+ */
+void osStackReport(U8 recommend) {
+  TCB info;
+  U32 used;
+
+  printf("TID  stack_size  used  free\r\n");
+  for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+    if (osTaskInfo(tid, &info) != RTX_OK || osStackUsage(tid, &used) != RTX_OK) continue;
+    printf("%3u  %10u  %4u  %4u\r\n", tid, info.stack_size, used, info.stack_size - used);
+  }
+
+  if (!recommend) return;
+
+  printf("Recommended stack_size:\r\n");
+  for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+    if (osTaskInfo(tid, &info) != RTX_OK || osStackUsage(tid, &used) != RTX_OK) continue;
+    U32 size = (used + used * STACK_MARGIN / 100 + 7) & ~7U;
+    if (size < STACK_SIZE) size = STACK_SIZE;
+    printf("  TID %u (entry %p): 0x%X, was 0x%X\r\n", tid, (void *)info.ptask, size, info.stack_size);
+  }
 }
 
 /**
@@ -100,16 +173,253 @@ task_t osGetTID(void) {
  * @retval None on success, RTX_ERR on failure
  */
 int osTaskExit(void) {
-  int ret;
-  __asm(
-    "SVC #6\n"
-    "MOV %[out], r0\n"
-    : [out] "=r" (ret)
+  register U32 r0 __asm("r0");
+  __asm volatile(
+      "SVC #6\n"
+      : "=r" (r0)
+      :
+      : "memory"
   );
   // This shouldn't return if the task exited properly
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to exit current task, keeping status for osTaskJoin()
+ *
+ * Unlike osTaskExit(), the task's slot and stack are held until it is
+ * joined or detached.
+ * 
+ * @retval None on success, RTX_ERR on failure
+ */
+int osTaskExitCode(int status) {
+  register U32 r0 __asm("r0") = (U32)status;
+  __asm volatile(
+      "SVC #73\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  // This shouldn't return if the task exited properly
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wait for a task to exit, blocking for up to timeout ms
+ *
+ * status may be NULL. The task's slot and stack are recycled once joined.
+ * The kernel writes the status through the pointer left in r1 when the
+ * task exits, so the arguments are bound to r0-r2.
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osTaskJoin(task_t tid, int *status, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = (U32)status;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #55\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to have a task's slot and stack recycled on exit without a join
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osTaskDetach(task_t tid) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  __asm volatile(
+      "SVC #56\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create an empty task group
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osGroupCreate(group_t *group) {
+  if (group == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)group;
+  __asm volatile(
+      "SVC #59\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a task as a member of a group
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osGroupSpawn(group_t group, TCB *task) {
+  if (task == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)group;
+  register U32 r1 __asm("r1") = (U32)task;
+  __asm volatile(
+      "SVC #60\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wait for every member of a group to exit, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osGroupWait(group_t group, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)group;
+  register U32 r1 __asm("r1") = timeout;
+  __asm volatile(
+      "SVC #61\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to terminate every member of a group
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osGroupKill(group_t group) {
+  register U32 r0 __asm("r0") = (U32)group;
+  __asm volatile(
+      "SVC #62\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a work queue served by a pool of worker tasks
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osWorkqCreate(workq_t *wq, U32 workers, U16 stack_size) {
+  if (wq == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)wq;
+  register U32 r1 __asm("r1") = workers;
+  register U32 r2 __asm("r2") = (U32)stack_size;
+  __asm volatile(
+      "SVC #63\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to queue count jobs on a work queue at once
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the batch doesn't fit or on failure
+ */
+int osWorkqSubmit(workq_t wq, const workJob *jobs, U32 count) {
+  if (jobs == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)wq;
+  register U32 r1 __asm("r1") = (U32)jobs;
+  register U32 r2 __asm("r2") = count;
+  __asm volatile(
+      "SVC #64\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to fetch the next job for the calling worker, waiting for one
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the caller is not a worker
+ */
+int osWorkqNext(workJob *job) {
+  register U32 r0 __asm("r0") = (U32)job;
+  __asm volatile(
+      "SVC #65\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to register a run-to-completion handler
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osRtcCreate(rtc_t *handler, void (*fn)(void *arg), void *arg, U32 deadline) {
+  if (handler == NULL || fn == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)handler;
+  register U32 r1 __asm("r1") = (U32)fn;
+  register U32 r2 __asm("r2") = (U32)arg;
+  register U32 r3 __asm("r3") = deadline;
+  __asm volatile(
+      "SVC #66\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2), "r" (r3)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Activate a run-to-completion handler without entering the kernel through an SVC
+ *
+ * Safe to call from ISRs as well as tasks.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osRtcPost(rtc_t handler) {
+  U32 primask = __get_PRIMASK();
+  __disable_irq();
+  int ret = rtcPost(handler);
+  __set_PRIMASK(primask);
   return ret;
 }
 
+/**
+ * @brief Call SVC to fetch the next handler for the dispatcher, waiting for one
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the caller is not the dispatcher
+ */
+int osRtcNext(workJob *job) {
+  register U32 r0 __asm("r0") = (U32)job;
+  __asm volatile(
+      "SVC #67\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
 /**
  * @brief Call SVC to initialize memory
  * 
@@ -132,15 +442,14 @@ int k_mem_init() {
  * @retval Pointer to allocated memory on success, NULL on failure
  */
 void *k_mem_alloc(size_t size) {
-    void *ptr;
-    __asm(
+    register U32 r0 __asm("r0") = (U32)size;
+    __asm volatile(
         "SVC #8\n"
-        // Copy r0 to return var
-        "MOV %[out], r0\n"
-        : [out] "=r" (ptr)
-        : "r" (size)
+        : "+r" (r0)
+        :
+        : "memory"
     );
-    return ptr;
+    return (void *)r0;
 }
 
 /**
@@ -151,14 +460,14 @@ void *k_mem_alloc(size_t size) {
 int k_mem_dealloc(void * ptr) {
   if (ptr == NULL) return RTX_OK;
 
-  int ret;
-  __asm(
+  register U32 r0 __asm("r0") = (U32)ptr;
+  __asm volatile(
       "SVC #9\n"
-      // Copy r0 to return var
-      "MOV %[out], r0\n"
-      : [out] "=r" (ret)
+      : "+r" (r0)
+      :
+      : "memory"
   );
-  return ret;
+  return (int)r0;
 }
 
 /**
@@ -167,29 +476,962 @@ int k_mem_dealloc(void * ptr) {
  * @retval Number of free blocks smaller than size
  */
 int k_mem_count_extfrag(size_t size) {
+  register U32 r0 __asm("r0") = (U32)size;
+  __asm volatile(
+      "SVC #10\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to get heap usage statistics
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int k_mem_stats(memStats *stats) {
+  if (stats == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)stats;
+  __asm volatile(
+      "SVC #11\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to allocate a movable block
+ * 
+ * @retval RTX_OK and the block's handle on success, RTX_ERR on failure
+ */
+int k_mem_alloc_movable(size_t size, mem_handle_t *handle) {
+  if (handle == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)size;
+  register U32 r1 __asm("r1") = (U32)handle;
+  __asm volatile(
+      "SVC #14\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to pin a movable block and get its address
+ * 
+ * @retval Pointer to the block on success, NULL on failure
+ */
+void *k_mem_lock(mem_handle_t handle) {
+  register U32 r0 __asm("r0") = (U32)handle;
+  __asm volatile(
+      "SVC #15\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (void *)r0;
+}
+
+/**
+ * @brief Call SVC to unpin a movable block
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int k_mem_unlock(mem_handle_t handle) {
+  register U32 r0 __asm("r0") = (U32)handle;
+  __asm volatile(
+      "SVC #16\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to free a movable block
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int k_mem_dealloc_movable(mem_handle_t handle) {
+  register U32 r0 __asm("r0") = (U32)handle;
+  __asm volatile(
+      "SVC #17\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to compact movable blocks
+ * 
+ * @retval Size of the largest free block afterwards
+ */
+int k_mem_compact(void) {
   int ret;
   __asm(
-      "SVC #10\n"
+      "SVC #18\n"
       "MOV %[out], r0\n"
       : [out] "=r" (ret)
-      : "r" (size)       // size goes into r0
   );
   return ret;
 }
 
+/**
+ * @brief Call SVC to give a block owned by the caller to another task
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int k_mem_transfer(void *ptr, task_t tid) {
+  if (ptr == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)ptr;
+  register U32 r1 __asm("r1") = (U32)tid;
+  __asm volatile(
+      "SVC #27\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to allocate a reference-counted shared block
+ * 
+ * @retval Pointer to the block holding one reference, NULL on failure
+ */
+void *k_mem_alloc_shared(size_t size) {
+  register U32 r0 __asm("r0") = (U32)size;
+  __asm volatile(
+      "SVC #41\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (void *)r0;
+}
+
+/**
+ * @brief Add a reference to a shared block, without entering the kernel
+ * 
+ * @retval RTX_OK on success, RTX_ERR if ptr is not a live shared block
+ */
+int k_mem_retain(void *ptr) {
+  if (ptr == NULL) return RTX_ERR;
+
+  metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+  if (head->is_allocated != BLOCK_SHARED) return RTX_ERR;
+
+  U16 refs;
+  do {
+    refs = __LDREXH(&head->refs);
+    if (refs == 0 || refs == UINT16_MAX) {
+      __CLREX();
+      return RTX_ERR;
+    }
+  } while (__STREXH(refs + 1, &head->refs) != 0);
+  return RTX_OK;
+}
+
+/**
+ * @brief Drop a reference to a shared block, freeing it on the last one
+ *
+ * Only the final release traps into the kernel.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if ptr is not a live shared block
+ */
+int k_mem_release(void *ptr) {
+  if (ptr == NULL) return RTX_ERR;
+
+  metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+  if (head->is_allocated != BLOCK_SHARED) return RTX_ERR;
+
+  U16 refs;
+  do {
+    refs = __LDREXH(&head->refs);
+    if (refs == 0) {
+      __CLREX();
+      return RTX_ERR;
+    }
+  } while (__STREXH(refs - 1, &head->refs) != 0);
+  __DMB();
+
+  if (refs > 1) return RTX_OK;
+
+  // ptr is long gone from r0 after the loop above, put it back for the SVC
+  register U32 r0 __asm("r0") = (U32)ptr;
+  __asm volatile(
+      "SVC #42\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
 /**
  * @brief Call SVC to set deadline for a task
  * 
  * @retval RTX_OK on success, RTX_ERR on failure
  */
 int osSetDeadline(int deadline, task_t TID) {
-    int ret;
-    __asm(
-        "SVC #13\n"
-        // Copy r0 to return var
-        "MOV %[out], r0\n"
-        : [out] "=r" (ret)
-        : "r" (deadline), "r" (TID) // deadline and TID go into r0 and r1
+    register U32 r0 __asm("r0") = (U32)deadline;
+    register U32 r1 __asm("r1") = (U32)TID;
+    __asm volatile(
+        "SVC #12\n"
+        : "+r" (r0)
+        : "r" (r1)
+        : "memory"
     );
-    return ret;
+    return (int)r0;
+}
+
+/**
+ * @brief Call SVC to pin a task to a fixed priority level, 0 being the highest
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure or when not built with SCHED_FIXED_PRIORITY
+ */
+int osSetPriority(task_t tid, U32 priority) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = priority;
+  __asm volatile(
+      "SVC #71\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to move a task to SCHED_REALTIME or SCHED_BACKGROUND
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSetClass(task_t tid, U32 cls) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = cls;
+  __asm volatile(
+      "SVC #72\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to limit a task to wcet CPU cycles per deadline period
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSetBudget(task_t tid, U32 wcet, int (*on_overrun)(task_t tid)) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = wcet;
+  register U32 r2 __asm("r2") = (U32)on_overrun;
+  __asm volatile(
+      "SVC #70\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to give a task a CBS reservation of budget ms every period ms
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSetReservation(task_t tid, U32 budget, U32 period) {
+  register U32 r0 __asm("r0") = (U32)tid;
+  register U32 r1 __asm("r1") = budget;
+  register U32 r2 __asm("r2") = period;
+  __asm volatile(
+      "SVC #69\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a counting semaphore
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSemCreate(semaphore_t *sem, U32 count) {
+  if (sem == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)sem;
+  register U32 r1 __asm("r1") = count;
+  __asm volatile(
+      "SVC #19\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to take a semaphore, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osSemWait(semaphore_t sem, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)sem;
+  register U32 r1 __asm("r1") = timeout;
+  __asm volatile(
+      "SVC #20\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to give a semaphore
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSemPost(semaphore_t sem) {
+  register U32 r0 __asm("r0") = (U32)sem;
+  __asm volatile(
+      "SVC #21\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a mutex
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osMutexCreate(mutex_t *mutex) {
+  if (mutex == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)mutex;
+  __asm volatile(
+      "SVC #22\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to lock a mutex, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osMutexLock(mutex_t mutex, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)mutex;
+  register U32 r1 __asm("r1") = timeout;
+  __asm volatile(
+      "SVC #23\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to unlock a mutex
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osMutexUnlock(mutex_t mutex) {
+  register U32 r0 __asm("r0") = (U32)mutex;
+  __asm volatile(
+      "SVC #24\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to block while *addr == expected
+ *
+ * The kernel reads the arguments back from the stacked frame, so they are
+ * bound to r0-r2 explicitly.
+ * 
+ * @retval RTX_OK on wake or value change, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osFutexWait(volatile U32 *addr, U32 expected, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)addr;
+  register U32 r1 __asm("r1") = expected;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #25\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wake tasks blocked on addr
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osFutexWake(volatile U32 *addr, U32 count) {
+  register U32 r0 __asm("r0") = (U32)addr;
+  register U32 r1 __asm("r1") = count;
+  __asm volatile(
+      "SVC #26\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a message queue
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osQueueCreate(queue_t *queue, U32 capacity) {
+  if (queue == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)queue;
+  register U32 r1 __asm("r1") = capacity;
+  __asm volatile(
+      "SVC #28\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to send a message word, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osQueueSend(queue_t queue, U32 msg, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)queue;
+  register U32 r1 __asm("r1") = msg;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #29\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to send a k_mem block, handing its ownership to the receiver
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osQueueSendBlock(queue_t queue, void *block, U32 timeout) {
+  if (block == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)queue;
+  register U32 r1 __asm("r1") = (U32)block;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #30\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to receive a message, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osQueueReceive(queue_t queue, U32 *msg, U32 timeout) {
+  if (msg == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)queue;
+  register U32 r1 __asm("r1") = (U32)msg;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #31\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to block until a ring buffer holds data
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osRingWait(ringBuffer *ring, U32 timeout) {
+  if (ring == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)ring;
+  register U32 r1 __asm("r1") = timeout;
+  __asm volatile(
+      "SVC #32\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to register a readers-writer lock and set it unlocked
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osRwLockCreate(rwLock *lock) {
+  if (lock == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)lock;
+  __asm volatile(
+      "SVC #51\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Lock for reading, trapping into the kernel only under contention
+ *
+ * The uncontended path is a single LDREX/STREX in thread mode. Once a
+ * writer holds or waits for the lock, new readers queue in the kernel
+ * behind it. Like fast mutexes, these locks give no deadline inheritance.
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osRwLockRead(rwLock *lock, U32 timeout) {
+  if (lock == NULL) return RTX_ERR;
+
+  U32 state;
+  do {
+    state = __LDREXW(&lock->state);
+    if ((state & (RWLOCK_WRITER | RWLOCK_WAITING)) || (state & RWLOCK_READERS) == RWLOCK_READERS) {
+      __CLREX();
+      break;
+    }
+  } while (__STREXW(state + 1, &lock->state) != 0);
+
+  int ret = RTX_OK;
+  if (state & (RWLOCK_WRITER | RWLOCK_WAITING)) {
+    register U32 r0 __asm("r0") = lock->id;
+    register U32 r1 __asm("r1") = timeout;
+    __asm volatile(
+        "SVC #52\n"
+        : "+r" (r0)
+        : "r" (r1)
+        : "memory"
+    );
+    ret = (int)r0;
+  } else if ((state & RWLOCK_READERS) == RWLOCK_READERS) {
+    return RTX_ERR;
+  }
+  __DMB();
+  return ret;
+}
+
+/**
+ * @brief Lock for writing, trapping into the kernel only under contention
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osRwLockWrite(rwLock *lock, U32 timeout) {
+  if (lock == NULL) return RTX_ERR;
+
+  int ret = RTX_OK;
+  if (compareExchange(&lock->state, 0, RWLOCK_WRITER) != 0) {
+    register U32 r0 __asm("r0") = lock->id;
+    register U32 r1 __asm("r1") = timeout;
+    __asm volatile(
+        "SVC #53\n"
+        : "+r" (r0)
+        : "r" (r1)
+        : "memory"
+    );
+    ret = (int)r0;
+  }
+  __DMB();
+  return ret;
+}
+
+/**
+ * @brief Release a read or write hold, trapping into the kernel only if someone waits
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osRwLockUnlock(rwLock *lock) {
+  if (lock == NULL) return RTX_ERR;
+
+  __DMB();
+  U32 state;
+  do {
+    state = __LDREXW(&lock->state);
+    if ((state & RWLOCK_WAITING) && ((state & RWLOCK_WRITER) || (state & RWLOCK_READERS) == 1)) {
+      // Last holder out with waiters queued, the kernel picks who goes next
+      __CLREX();
+      register U32 r0 __asm("r0") = lock->id;
+      __asm volatile(
+          "SVC #54\n"
+          : "+r" (r0)
+          :
+          : "memory"
+      );
+      return (int)r0;
+    }
+    if (!(state & RWLOCK_WRITER) && (state & RWLOCK_READERS) == 0) {
+      __CLREX();
+      return RTX_ERR;
+    }
+  } while (__STREXW((state & RWLOCK_WRITER) ? (state & ~RWLOCK_WRITER) : state - 1, &lock->state) != 0);
+  return RTX_OK;
+}
+
+/**
+ * @brief Call SVC to create a barrier released once parties tasks have arrived
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osBarrierCreate(barrier_t *barrier, U32 parties) {
+  if (barrier == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)barrier;
+  register U32 r1 __asm("r1") = parties;
+  __asm volatile(
+      "SVC #57\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wait at a barrier, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osBarrierWait(barrier_t barrier, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)barrier;
+  register U32 r1 __asm("r1") = timeout;
+  __asm volatile(
+      "SVC #58\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a condition variable
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osCondCreate(cond_t *cond) {
+  if (cond == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)cond;
+  __asm volatile(
+      "SVC #47\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to unlock mutex and wait on cond, blocking for up to timeout ms
+ *
+ * Returns with the mutex held, including after a timeout.
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osCondWait(cond_t cond, mutex_t mutex, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)cond;
+  register U32 r1 __asm("r1") = (U32)mutex;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #48\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  int ret = (int)r0;
+  if (ret == RTX_TIMEOUT) {
+    osMutexLock(mutex, OS_WAIT_FOREVER);
+  }
+  return ret;
+}
+
+/**
+ * @brief Call SVC to release the most urgent waiter of a condition variable
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osCondSignal(cond_t cond) {
+  register U32 r0 __asm("r0") = (U32)cond;
+  __asm volatile(
+      "SVC #49\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to release every waiter of a condition variable
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osCondBroadcast(cond_t cond) {
+  register U32 r0 __asm("r0") = (U32)cond;
+  __asm volatile(
+      "SVC #50\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create an event flag group
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osEventCreate(event_t *event) {
+  if (event == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)event;
+  __asm volatile(
+      "SVC #33\n"
+      : "+r" (r0)
+      :
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Set event flags, from a task or an ISR
+ *
+ * An ISR is already in handler mode and can't raise an SVC, so it calls
+ * the kernel directly; eventSet() masks interrupts itself.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osEventSet(event_t event, U32 mask) {
+  if (__get_IPSR() != 0) {
+    return eventSet(event, mask);
+  }
+
+  register U32 r0 __asm("r0") = event;
+  register U32 r1 __asm("r1") = mask;
+  __asm volatile(
+      "SVC #34\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to clear event flags
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osEventClear(event_t event, U32 mask) {
+  register U32 r0 __asm("r0") = (U32)event;
+  register U32 r1 __asm("r1") = mask;
+  __asm volatile(
+      "SVC #35\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wait for event flags, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osEventWait(event_t event, U32 mask, U32 mode, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)event;
+  register U32 r1 __asm("r1") = mask;
+  register U32 r2 __asm("r2") = mode;
+  register U32 r3 __asm("r3") = timeout;
+  __asm volatile(
+      "SVC #36\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2), "r" (r3)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to send a request to a server and wait for its reply
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSend(task_t server, ipcMsg *msg) {
+  if (msg == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)server;
+  register U32 r1 __asm("r1") = (U32)msg;
+  __asm volatile(
+      "SVC #37\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to wait for a client request, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osReceive(task_t *client, void *buf, U32 len, U32 timeout) {
+  if (client == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)client;
+  register U32 r1 __asm("r1") = (U32)buf;
+  register U32 r2 __asm("r2") = len;
+  register U32 r3 __asm("r3") = timeout;
+  __asm volatile(
+      "SVC #38\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2), "r" (r3)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to reply to a client and release it
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osReply(task_t client, const void *reply, U32 len) {
+  register U32 r0 __asm("r0") = (U32)client;
+  register U32 r1 __asm("r1") = (U32)reply;
+  register U32 r2 __asm("r2") = len;
+  __asm volatile(
+      "SVC #39\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to create a pub/sub topic
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osTopicCreate(topic_t *topic, U32 size) {
+  if (topic == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)topic;
+  register U32 r1 __asm("r1") = size;
+  __asm volatile(
+      "SVC #43\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to subscribe to a topic, queueing up to depth samples
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osSubscribe(topic_t topic, U32 depth, subscription_t *sub) {
+  if (sub == NULL) return RTX_ERR;
+
+  register U32 r0 __asm("r0") = (U32)topic;
+  register U32 r1 __asm("r1") = depth;
+  register U32 r2 __asm("r2") = (U32)sub;
+  __asm volatile(
+      "SVC #44\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to publish a sample to a topic
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osPublish(topic_t topic, const void *data) {
+  register U32 r0 __asm("r0") = (U32)topic;
+  register U32 r1 __asm("r1") = (U32)data;
+  __asm volatile(
+      "SVC #45\n"
+      : "+r" (r0)
+      : "r" (r1)
+      : "memory"
+  );
+  return (int)r0;
+}
+
+/**
+ * @brief Call SVC to receive the next sample of a subscription, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osTopicReceive(subscription_t sub, void *buf, U32 timeout) {
+  register U32 r0 __asm("r0") = (U32)sub;
+  register U32 r1 __asm("r1") = (U32)buf;
+  register U32 r2 __asm("r2") = timeout;
+  __asm volatile(
+      "SVC #46\n"
+      : "+r" (r0)
+      : "r" (r1), "r" (r2)
+      : "memory"
+  );
+  return (int)r0;
 }
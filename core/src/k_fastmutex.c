@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include "common.h"
+#include "k_atomic.h"
+#include "stm32f401xe.h"
+
+/**
+ * @brief Initialize a fast mutex as unlocked
+ * 
+ * @retval None
+ */
+void osFastMutexInit(fastMutex *mutex) {
+    mutex->state = FAST_MUTEX_UNLOCKED;
+}
+
+/**
+ * @brief Lock a fast mutex, trapping into the kernel only under contention
+ *
+ * The uncontended path is a single LDREX/STREX in thread mode. A contended
+ * locker marks the mutex FAST_MUTEX_CONTENDED and sleeps in the kernel until
+ * the holder wakes it. timeout applies to each sleep. Fast mutexes carry no
+ * owner, so they give no deadline inheritance; use osMutexLock() for that.
+ * 
+ * @retval RTX_OK on success, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int osFastMutexLock(fastMutex *mutex, U32 timeout) {
+    if (mutex == NULL) return RTX_ERR;
+
+    U32 state = compareExchange(&mutex->state, FAST_MUTEX_UNLOCKED, FAST_MUTEX_LOCKED);
+    if (state != FAST_MUTEX_UNLOCKED) {
+        if (state != FAST_MUTEX_CONTENDED) {
+            state = exchange(&mutex->state, FAST_MUTEX_CONTENDED);
+        }
+        while (state != FAST_MUTEX_UNLOCKED) {
+            int ret = osFutexWait(&mutex->state, FAST_MUTEX_CONTENDED, timeout);
+            if (ret != RTX_OK) return ret;
+            state = exchange(&mutex->state, FAST_MUTEX_CONTENDED);
+        }
+    }
+    __DMB();
+    return RTX_OK;
+}
+
+/**
+ * @brief Unlock a fast mutex, trapping into the kernel only if someone waits
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osFastMutexUnlock(fastMutex *mutex) {
+    if (mutex == NULL) return RTX_ERR;
+
+    __DMB();
+    if (exchange(&mutex->state, FAST_MUTEX_UNLOCKED) == FAST_MUTEX_CONTENDED) {
+        return osFutexWake(&mutex->state, 1);
+    }
+    return RTX_OK;
+}
@@ -1,9 +1,10 @@
 #include <stdio.h>
+#include <string.h>
 #include "k_mem.h"
 #include "k_task.h"
 #include "stm32f401xe.h"
 
-extern U32 _img_end; // end of the image, defined in linker script
+extern U32 _end; // end of .bss, start of the heap, defined in linker script
 extern U32 _estack; // end of the stack, defined in linker script
 extern U32 _Min_Stack_Size; // minimum stack size, defined in linker script
 
@@ -13,24 +14,45 @@ static int already_initialized = 0;
 extern task_t running_task;
 
 size_t max_heap_size;
+static size_t bytes_allocated = 0; // payload bytes currently handed out
+static U32 blocks_allocated = 0; // number of blocks currently handed out
+
+static U8 *heap_start; // address of the first block header
+static U8 *heap_end; // one past the last byte of the heap
+
+static metaHeader *handle_table[MAX_HANDLES]; // current header of each movable block
+static U32 handle_locks[MAX_HANDLES]; // outstanding mem_lock() calls per handle
+static U32 movable_count = 0; // live movable blocks, compaction is pointless without any
 
 /**
  * @brief Initialize memory management system
+ *
+ * The heap spans everything between the end of .bss and the reserved MSP
+ * stack. It also backs newlib's malloc (see sysmem.c), so there is only one
+ * pool of free memory in the system.
  * 
  * @retval RTX_OK on success, RTX_ERR on failure
  */
 int mem_init() {
     if (already_initialized) return RTX_ERR;
 
-    freelist_head = (metaHeader *)&_img_end; // start of free memory
-     // initial full heap size
-    freelist_head->size = ( (U32)(&_estack) - (U32)(&_Min_Stack_Size) ) - (U32)(&_img_end);
+    heap_start = (U8 *)&_end; // start of free memory
+    heap_end = (U8 *)((U32)(&_estack) - (U32)(&_Min_Stack_Size));
+
+    if (heap_end - heap_start < (int)(METADATA_SIZE + 4)) {
+        return RTX_ERR; // not enough memory for metadata
+    }
+
+    freelist_head = (metaHeader *)heap_start;
+     // initial full heap size, less the header of the one free block
+    freelist_head->size = (heap_end - heap_start) - METADATA_SIZE;
     freelist_head->next = NULL; // no next block
     freelist_head->tid = TID_NULL; // no owner
-    freelist_head->is_allocated = 0; // initially free
+    freelist_head->is_allocated = BLOCK_FREE; // initially free
 
-    if (freelist_head->size < sizeof(metaHeader)) {
-        return RTX_ERR; // not enough memory for metadata
+    for (int i = 0; i < MAX_HANDLES; i++) {
+        handle_table[i] = NULL;
+        handle_locks[i] = 0;
     }
 
     already_initialized = 1;
@@ -40,15 +62,11 @@ int mem_init() {
 }
 
 /**
- * @brief Allocate a block of memory requested by the user (DEBUG VERSION)
+ * @brief First-fit search of the freelist for an aligned request
  *
- * @retval Pointer to allocated memory, or NULL if request fails
+ * @retval Pointer to allocated memory, or NULL if no free block is large enough
  */
-void * mem_alloc(size_t size) {
-    if (!already_initialized || size == 0) return NULL;
-
-    size = (size + 3) & ~3; // align size to 4 bytes
-
+static void * first_fit(size_t size) {
     // traverse the freelist to find a suitable block
     metaHeader *current = freelist_head;
     metaHeader *prev = NULL;
@@ -65,14 +83,16 @@ void * mem_alloc(size_t size) {
                 new_block->size = remaining_size - METADATA_SIZE;
                 new_block->next = current->next;
                 new_block->tid = TID_NULL;
-                new_block->is_allocated = 0;
+                new_block->is_allocated = BLOCK_FREE;
 
                 current->size = size;
                 current->next = new_block;
             }
 
-            current->is_allocated = 1;
+            current->is_allocated = BLOCK_ALLOCATED;
             current->tid = (U8)getTID();
+            bytes_allocated += current->size;
+            blocks_allocated++;
 
             if (prev == NULL) {
                 // head of freelist
@@ -103,19 +123,37 @@ void * mem_alloc(size_t size) {
     return NULL;
 }
 
-int mem_dealloc(void *ptr) {
-    // Check kernel memory structures are initialized
-    if (!already_initialized) return RTX_ERR;
+/**
+ * @brief Allocate a block of memory requested by the user
+ *
+ * If no free block is large enough, movable blocks are compacted toward the
+ * start of the heap and the search is retried once.
+ *
+ * @retval Pointer to allocated memory, or NULL if request fails
+ */
+void * mem_alloc(size_t size) {
+    if (!already_initialized || size == 0) return NULL;
 
-    // Do nothing is ptr is null
-    if (ptr == NULL) return RTX_OK;
+    size = (size + 3) & ~3; // align size to 4 bytes
 
-    // Check for valid ptr
-    metaHeader *head = (metaHeader *) ((U8 *)ptr - METADATA_SIZE);
-    if (head == NULL || head->is_allocated == 0 || (task_t)head->tid != running_task || head->size > max_heap_size) return RTX_ERR;
+    void *ptr = first_fit(size);
+    if (ptr == NULL && movable_count > 0 && (size_t)mem_compact() >= size) {
+        ptr = first_fit(size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief Return an allocated block of any kind to the freelist, coalescing neighbours
+ *
+ * @retval RTX_OK
+ */
+static int free_block(metaHeader *head) {
+    bytes_allocated -= head->size;
+    blocks_allocated--;
 
     // Clear metadata
-    head->is_allocated = 0;
+    head->is_allocated = BLOCK_FREE;
     head->tid = TID_NULL;
 
     // Add block to freelist
@@ -123,6 +161,8 @@ int mem_dealloc(void *ptr) {
     metaHeader *prev = NULL;
     while (1) {
         if (tmp == NULL) {
+            // Heap was full, the block is the whole freelist
+            head->next = NULL;
             freelist_head = head;
             tmp = freelist_head;
             break;
@@ -178,6 +218,56 @@ int mem_dealloc(void *ptr) {
     return RTX_OK;
 }
 
+int mem_dealloc(void *ptr) {
+    return mem_dealloc_owned(ptr, running_task);
+}
+
+/**
+ * @brief Find the header of a pinned block, checking it lies in the heap
+ * 
+ * @retval Header of the block, NULL if ptr is not a pinned block owned by owner
+ */
+static metaHeader *ownedBlock(void *ptr, task_t owner) {
+    metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+    if ((U8 *)head < heap_start || (U8 *)ptr >= heap_end) return NULL;
+    if (head->is_allocated != BLOCK_ALLOCATED || (task_t)head->tid != owner || head->size > max_heap_size) return NULL;
+    return head;
+}
+
+/**
+ * @brief Free a pinned block on behalf of its owner
+ *
+ * Lets the kernel release memory held by a task other than the running
+ * one, such as the stack of a task being reaped.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if ptr is not a block owned by owner
+ */
+int mem_dealloc_owned(void *ptr, task_t owner) {
+    // Check kernel memory structures are initialized
+    if (!already_initialized) return RTX_ERR;
+
+    // Do nothing is ptr is null
+    if (ptr == NULL) return RTX_OK;
+
+    // Check for valid ptr
+    metaHeader *head = ownedBlock(ptr, owner);
+    if (head == NULL) return RTX_ERR;
+
+    return free_block(head);
+}
+
+/**
+ * @brief Get the usable size of a pinned block owned by the running task
+ * 
+ * @retval Payload size in bytes, 0 if ptr is not such a block
+ */
+size_t mem_size(void *ptr) {
+    if (!already_initialized || ptr == NULL) return 0;
+
+    metaHeader *head = ownedBlock(ptr, running_task);
+    return (head != NULL) ? head->size : 0;
+}
+
 int mem_count_extfrag(size_t size) {
     if (!already_initialized || freelist_head == NULL) {
         return 0; 
@@ -194,4 +284,219 @@ int mem_count_extfrag(size_t size) {
     }
 
     return count;
-}
\ No newline at end of file
+}
+/**
+ * @brief Fill in usage statistics for the heap
+ *
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int mem_stats(memStats *stats) {
+    if (!already_initialized || stats == NULL) return RTX_ERR;
+
+    stats->heap_size = max_heap_size;
+    stats->bytes_allocated = bytes_allocated;
+    stats->blocks_allocated = blocks_allocated;
+    stats->bytes_free = 0;
+    stats->blocks_free = 0;
+    stats->largest_free = 0;
+
+    for (metaHeader *curr = freelist_head; curr != NULL; curr = curr->next) {
+        stats->bytes_free += curr->size;
+        stats->blocks_free++;
+        if (curr->size > stats->largest_free) {
+            stats->largest_free = curr->size;
+        }
+    }
+
+    return RTX_OK;
+}
+
+/**
+ * @brief Allocate a block that the kernel may relocate while it is unlocked
+ *
+ * @retval RTX_OK and the block's handle on success, RTX_ERR on failure
+ */
+int mem_alloc_movable(size_t size, mem_handle_t *handle) {
+    if (!already_initialized || handle == NULL) return RTX_ERR;
+
+    mem_handle_t h;
+    for (h = 0; h < MAX_HANDLES; h++) {
+        if (handle_table[h] == NULL) break;
+    }
+    if (h == MAX_HANDLES) return RTX_ERR;
+
+    void *ptr = mem_alloc(size);
+    if (ptr == NULL) return RTX_ERR;
+
+    metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+    head->is_allocated = BLOCK_MOVABLE;
+    head->handle = h;
+    handle_table[h] = head;
+    handle_locks[h] = 0;
+    movable_count++;
+
+    *handle = h;
+    return RTX_OK;
+}
+
+/**
+ * @brief Pin a movable block and get its current address
+ *
+ * The address stays valid until the matching mem_unlock(). Locks nest.
+ *
+ * @retval Pointer to the block's payload, or NULL if the handle is invalid
+ */
+void * mem_lock(mem_handle_t handle) {
+    if (handle >= MAX_HANDLES || handle_table[handle] == NULL) return NULL;
+
+    handle_locks[handle]++;
+    return (U8 *)handle_table[handle] + METADATA_SIZE;
+}
+
+/**
+ * @brief Release one lock on a movable block, allowing it to move again
+ *
+ * @retval RTX_OK on success, RTX_ERR if the handle is invalid or not locked
+ */
+int mem_unlock(mem_handle_t handle) {
+    if (handle >= MAX_HANDLES || handle_table[handle] == NULL || handle_locks[handle] == 0) return RTX_ERR;
+
+    handle_locks[handle]--;
+    return RTX_OK;
+}
+
+/**
+ * @brief Free a movable block and its handle
+ *
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int mem_dealloc_movable(mem_handle_t handle) {
+    if (handle >= MAX_HANDLES || handle_table[handle] == NULL) return RTX_ERR;
+
+    metaHeader *head = handle_table[handle];
+    if ((task_t)head->tid != running_task) return RTX_ERR;
+
+    free_block(head);
+    handle_table[handle] = NULL;
+    handle_locks[handle] = 0;
+    movable_count--;
+    return RTX_OK;
+}
+
+/**
+ * @brief Slide unlocked movable blocks toward the start of the heap
+ *
+ * Walks every block in address order. Movable, unlocked blocks are copied
+ * down over any free space in front of them and their handles updated;
+ * pinned blocks (ordinary or locked allocations) stay put. The free space
+ * that remains is rebuilt into an address-ordered freelist. Every free
+ * region is at least METADATA_SIZE + 4 bytes before compaction and regions
+ * only merge, so each gap can always hold a header.
+ *
+ * @retval Size of the largest free block after compaction
+ */
+int mem_compact(void) {
+    if (!already_initialized) return 0;
+
+    U8 *cursor = heap_start; // where the next kept block will start
+    metaHeader *tail = NULL; // last block of the rebuilt freelist
+    size_t largest = 0;
+    freelist_head = NULL;
+
+    metaHeader *block = (metaHeader *)heap_start;
+    while ((U8 *)block < heap_end) {
+        size_t span = METADATA_SIZE + block->size;
+        metaHeader *next = (metaHeader *)((U8 *)block + span);
+
+        if (block->is_allocated == BLOCK_MOVABLE && handle_locks[block->handle] == 0) {
+            if ((U8 *)block != cursor) {
+                memmove(cursor, block, span);
+                handle_table[((metaHeader *)cursor)->handle] = (metaHeader *)cursor;
+            }
+            cursor += span;
+        } else if (block->is_allocated != BLOCK_FREE) {
+            if ((U8 *)block != cursor) {
+                // Free space left in front of a pinned block
+                metaHeader *gap = (metaHeader *)cursor;
+                gap->size = (U8 *)block - cursor - METADATA_SIZE;
+                gap->tid = TID_NULL;
+                gap->is_allocated = BLOCK_FREE;
+                gap->next = NULL;
+                if (tail == NULL) freelist_head = gap;
+                else tail->next = gap;
+                tail = gap;
+                if (gap->size > largest) largest = gap->size;
+            }
+            cursor = (U8 *)block + span;
+        }
+        block = next;
+    }
+
+    if (cursor < heap_end) {
+        metaHeader *gap = (metaHeader *)cursor;
+        gap->size = heap_end - cursor - METADATA_SIZE;
+        gap->tid = TID_NULL;
+        gap->is_allocated = BLOCK_FREE;
+        gap->next = NULL;
+        if (tail == NULL) freelist_head = gap;
+        else tail->next = gap;
+        if (gap->size > largest) largest = gap->size;
+    }
+
+    return (int)largest;
+}
+
+/**
+ * @brief Hand an allocated block from one owner to another
+ *
+ * After the transfer only the new owner may free the block. TID_NULL is
+ * used as the owner of blocks in flight inside kernel objects.
+ *
+ * @retval RTX_OK on success, RTX_ERR if ptr is not a block owned by from
+ */
+int mem_transfer(void *ptr, task_t from, task_t to) {
+    if (!already_initialized || ptr == NULL || to >= MAX_TASKS) return RTX_ERR;
+
+    metaHeader *head = ownedBlock(ptr, from);
+    if (head == NULL) return RTX_ERR;
+
+    head->tid = (U8)to;
+    return RTX_OK;
+}
+
+/**
+ * @brief Allocate a reference-counted block that any task may release
+ *
+ * The block starts with one reference. Holders add and drop references
+ * with k_mem_retain()/k_mem_release() without entering the kernel; the
+ * last release frees it through mem_dealloc_shared(), whoever calls it.
+ *
+ * @retval Pointer to allocated memory, or NULL if request fails
+ */
+void * mem_alloc_shared(size_t size) {
+    void *ptr = mem_alloc(size);
+    if (ptr == NULL) return NULL;
+
+    metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+    head->is_allocated = BLOCK_SHARED;
+    head->refs = 1;
+    return ptr;
+}
+
+/**
+ * @brief Free a shared block whose last reference has been released
+ *
+ * Exempt from the owner check in mem_dealloc(): the last holder to release
+ * a shared block is rarely the task that allocated it.
+ *
+ * @retval RTX_OK on success, RTX_ERR if ptr is not an unreferenced shared block
+ */
+int mem_dealloc_shared(void *ptr) {
+    if (!already_initialized || ptr == NULL) return RTX_ERR;
+
+    metaHeader *head = (metaHeader *)((U8 *)ptr - METADATA_SIZE);
+    if ((U8 *)head < heap_start || (U8 *)ptr >= heap_end) return RTX_ERR;
+    if (head->is_allocated != BLOCK_SHARED || head->refs != 0 || head->size > max_heap_size) return RTX_ERR;
+
+    return free_block(head);
+}
@@ -0,0 +1,437 @@
+#include <stdio.h>
+#include <string.h>
+#include "k_msg.h"
+#include "k_task.h"
+#include "k_mem.h"
+#include "stm32f401xe.h"
+
+extern TCB tasks[MAX_TASKS];
+extern kernelTCB ktasks[MAX_TASKS];
+extern task_t running_task;
+
+static msgQueue queues[MAX_QUEUES];
+
+topic topics[MAX_TOPICS];
+static subscription subscriptions[MAX_SUBSCRIPTIONS];
+
+static waitQueue ipc_senders[MAX_TASKS]; // clients waiting for each server to receive
+static waitQueue ipc_receivers[MAX_TASKS]; // each server, while blocked in ipcReceive()
+static waitQueue ipc_repliers[MAX_TASKS]; // clients each server has received but not replied to
+
+/**
+ * @brief Allocate a message queue with room for capacity messages
+ * 
+ * @retval RTX_OK and the queue ID on success, RTX_ERR on failure
+ */
+int queueCreate(queue_t *queue, U32 capacity) {
+    if (queue == NULL || capacity == 0) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_QUEUES; i++) {
+        if (!queues[i].in_use) {
+            queueSlot *slots = mem_alloc(capacity * sizeof(queueSlot));
+            if (slots == NULL) {
+                return RTX_ERR;
+            }
+            queues[i].in_use = 1;
+            queues[i].capacity = capacity;
+            queues[i].count = 0;
+            queues[i].head = 0;
+            queues[i].slots = slots;
+            queues[i].senders.head = NULL;
+            queues[i].receivers.head = NULL;
+            *queue = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Append a message to the tail of a queue that has room
+ * 
+ * @retval None
+ */
+static void queuePush(msgQueue *q, U32 msg, U32 is_block) {
+    queueSlot *slot = &q->slots[(q->head + q->count) % q->capacity];
+    slot->msg = msg;
+    slot->is_block = is_block;
+    q->count++;
+}
+
+/**
+ * @brief Send a message, blocking for up to timeout ms while the queue is full
+ *
+ * A waiting receiver gets the message directly. If is_block is set, msg
+ * must be a k_mem block owned by the caller; it is held by the kernel while
+ * queued and owned by the receiver once delivered, so the payload is never
+ * copied.
+ * 
+ * @retval RTX_OK once queued, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int queueSend(queue_t queue, U32 msg, U32 timeout, U32 is_block) {
+    if (queue >= MAX_QUEUES || !queues[queue].in_use) {
+        return RTX_ERR;
+    }
+    msgQueue *q = &queues[queue];
+
+    if (q->receivers.head != NULL) {
+        task_t receiver = q->receivers.head->tid;
+        if (is_block && mem_transfer((void *)msg, running_task, receiver) != RTX_OK) {
+            return RTX_ERR;
+        }
+        // The receiver's out pointer is still in r1 of its blocked SVC
+        *(U32 *)ktasks[receiver].wait_frame[1] = msg;
+        wakeTask(receiver, RTX_OK);
+        preemptIfEarlier(receiver);
+        return RTX_OK;
+    }
+
+    if (q->count < q->capacity) {
+        if (is_block && mem_transfer((void *)msg, running_task, TID_NULL) != RTX_OK) {
+            return RTX_ERR;
+        }
+        queuePush(q, msg, is_block);
+        return RTX_OK;
+    }
+
+    // Only check ownership here, the block moves once there is room for it
+    if (is_block && mem_transfer((void *)msg, running_task, running_task) != RTX_OK) {
+        return RTX_ERR;
+    }
+    ktasks[running_task].wait_info = is_block;
+    return blockTask(&q->senders, timeout);
+}
+
+/**
+ * @brief Take the oldest message, blocking for up to timeout ms while the queue is empty
+ *
+ * Freeing a slot lets the most urgent blocked sender deposit its message.
+ * 
+ * @retval RTX_OK once a message is received, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int queueReceive(queue_t queue, U32 *msg, U32 timeout) {
+    if (queue >= MAX_QUEUES || !queues[queue].in_use || msg == NULL) {
+        return RTX_ERR;
+    }
+    msgQueue *q = &queues[queue];
+
+    if (q->count == 0) {
+        return blockTask(&q->receivers, timeout);
+    }
+
+    queueSlot *slot = &q->slots[q->head];
+    if (slot->is_block) {
+        mem_transfer((void *)slot->msg, TID_NULL, running_task);
+    }
+    *msg = slot->msg;
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+
+    if (q->senders.head != NULL) {
+        task_t sender = q->senders.head->tid;
+        U32 sent = ktasks[sender].wait_frame[1];
+        U32 is_block = ktasks[sender].wait_info;
+        if (is_block) {
+            mem_transfer((void *)sent, sender, TID_NULL);
+        }
+        queuePush(q, sent, is_block);
+        wakeTask(sender, RTX_OK);
+        preemptIfEarlier(sender);
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Recompute the deadline a server borrows from its clients
+ *
+ * Both queues are deadline ordered, so only their heads matter.
+ * 
+ * @retval None
+ */
+static void updateDonation(task_t server) {
+    U32 donated = 0;
+    if (ipc_senders[server].head != NULL) {
+        donated = taskKey(ipc_senders[server].head->tid);
+    }
+    if (ipc_repliers[server].head != NULL) {
+        U32 key = taskKey(ipc_repliers[server].head->tid);
+        if (donated == 0 || key < donated) {
+            donated = key;
+        }
+    }
+    ktasks[server].donated_left = donated;
+    keyChanged(server);
+}
+
+/**
+ * @brief Copy a client's request into a receiving server's buffer
+ * 
+ * @retval None
+ */
+static void ipcDeliver(task_t client, ipcMsg *msg, task_t *client_out, void *buf, U32 len) {
+    memcpy(buf, msg->msg, msg->msg_len < len ? msg->msg_len : len);
+    *client_out = client;
+}
+
+/**
+ * @brief Send a request to a server and block until it replies
+ *
+ * If the server is already waiting in ipcReceive(), the request is copied
+ * into its buffer and the server is donated the client's deadline. That
+ * makes it at least as urgent as the client was, so unless it is throttled
+ * or in the background the kernel switches straight to it without a
+ * selection pass. Otherwise the client queues on the server in deadline
+ * order and the server borrows its deadline.
+ * 
+ * @retval RTX_OK once replied to, RTX_ERR on failure
+ */
+int ipcSend(task_t server, ipcMsg *msg) {
+    if (server >= MAX_TASKS || server == running_task || msg == NULL || tasks[server].tid == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    if (ipc_receivers[server].head != NULL) {
+        U32 minimum = taskKey(running_task);
+        // r0 of the blocked SVC already holds its provisional retval, so the
+        // client out-pointer was kept in wait_info; buf and len are in r1, r2
+        U32 *frame = ktasks[server].wait_frame;
+        ipcDeliver(running_task, msg, (task_t *)ktasks[server].wait_info, (void *)frame[1], frame[2]);
+        wakeTask(server, RTX_OK);
+
+        int ret = parkTask(&ipc_repliers[server], OS_WAIT_FOREVER);
+        updateDonation(server);
+        handoffTask(server, minimum);
+        return ret;
+    }
+
+    int ret = blockTask(&ipc_senders[server], OS_WAIT_FOREVER);
+    updateDonation(server);
+    // The server may now be the earliest task
+    scheduler();
+    return ret;
+}
+
+/**
+ * @brief Wait for a request, blocking for up to timeout ms
+ *
+ * Takes the most urgent waiting client first. Requests longer than len
+ * are truncated.
+ * 
+ * @retval RTX_OK once a request is received, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int ipcReceive(task_t *client, void *buf, U32 len, U32 timeout) {
+    if (client == NULL || (buf == NULL && len > 0) || running_task == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    if (ipc_senders[running_task].head == NULL) {
+        int ret = blockTask(&ipc_receivers[running_task], timeout);
+        ktasks[running_task].wait_info = (U32)client;
+        return ret;
+    }
+
+    task_t sender = ipc_senders[running_task].head->tid;
+    ipcDeliver(sender, (ipcMsg *)ktasks[sender].wait_frame[1], client, buf, len);
+    moveWaiter(sender, &ipc_repliers[running_task], OS_WAIT_FOREVER);
+    return RTX_OK;
+}
+
+/**
+ * @brief Reply to a client received earlier, releasing it
+ *
+ * Replies longer than the client's reply buffer are truncated, and the
+ * client's reply_len is set to the bytes copied. The server gives back the
+ * deadline it borrowed from the client.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if client is not waiting on our reply
+ */
+int ipcReply(task_t client, const void *reply, U32 len) {
+    if (client >= MAX_TASKS || running_task == TID_NULL || tasks[client].state != BLOCKED
+        || ktasks[client].wait_queue != &ipc_repliers[running_task]) {
+        return RTX_ERR;
+    }
+
+    ipcMsg *msg = (ipcMsg *)ktasks[client].wait_frame[1];
+    U32 copied = len < msg->reply_len ? len : msg->reply_len;
+    if (copied > 0) {
+        memcpy(msg->reply, reply, copied);
+    }
+    msg->reply_len = copied;
+
+    wakeTask(client, RTX_OK);
+    updateDonation(running_task);
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Allocate a topic carrying samples of size bytes
+ * 
+ * @retval RTX_OK and the topic ID on success, RTX_ERR on failure
+ */
+int topicCreate(topic_t *topic, U32 size) {
+    if (topic == NULL || size == 0) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_TOPICS; i++) {
+        if (!topics[i].in_use) {
+            U8 *latest = mem_alloc(size);
+            if (latest == NULL) {
+                return RTX_ERR;
+            }
+            topics[i].in_use = 1;
+            topics[i].size = size;
+            osSeqlockInit(&topics[i].lock);
+            topics[i].latest = latest;
+            topics[i].waiters.head = NULL;
+            *topic = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Subscribe the caller to a topic
+ *
+ * With depth 0 the subscriber only ever sees the latest sample; otherwise
+ * up to depth samples are queued for it and the oldest is dropped when a
+ * publish finds the queue full.
+ * 
+ * @retval RTX_OK and the subscription ID on success, RTX_ERR on failure
+ */
+int subscribe(topic_t topic, U32 depth, subscription_t *sub) {
+    if (topic >= MAX_TOPICS || !topics[topic].in_use || sub == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; i++) {
+        if (!subscriptions[i].in_use) {
+            U8 *samples = NULL;
+            if (depth > 0) {
+                samples = mem_alloc(depth * topics[topic].size);
+                if (samples == NULL) {
+                    return RTX_ERR;
+                }
+            }
+            subscriptions[i].in_use = 1;
+            subscriptions[i].topic = topic;
+            subscriptions[i].depth = depth;
+            subscriptions[i].count = 0;
+            subscriptions[i].head = 0;
+            subscriptions[i].last_seq = topics[topic].lock.seq;
+            subscriptions[i].dropped = 0;
+            subscriptions[i].samples = samples;
+            *sub = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Publish a sample to every subscriber of a topic
+ *
+ * The latest-value copy is written under the topic's seqlock so
+ * osTopicRead() never returns a torn sample. Blocked subscribers get the
+ * sample copied straight into their buffer and are woken in deadline
+ * order in this one pass; everyone else with a queue gets it queued.
+ * PendSV is triggered at most once.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int publish(topic_t topic, const void *data) {
+    if (topic >= MAX_TOPICS || !topics[topic].in_use || data == NULL) {
+        return RTX_ERR;
+    }
+    struct topic *t = &topics[topic];
+
+    osSeqlockWrite(&t->lock, t->latest, data, t->size);
+
+    // Hand the sample directly to subscribers already waiting for one
+    task_t earliest = TID_NULL;
+    TCB *waiter = t->waiters.head;
+    while (waiter != NULL) {
+        TCB *next = ktasks[waiter->tid].wait_next;
+        // r0 of the blocked SVC already holds its provisional retval, so the
+        // subscription was kept in wait_info; the buffer is still in r1
+        subscription *s = &subscriptions[ktasks[waiter->tid].wait_info];
+        memcpy((void *)ktasks[waiter->tid].wait_frame[1], data, t->size);
+        s->last_seq = t->lock.seq;
+        if (earliest == TID_NULL) {
+            earliest = waiter->tid;
+        }
+        wakeTask(waiter->tid, RTX_OK);
+        waiter = next;
+    }
+
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; i++) {
+        subscription *s = &subscriptions[i];
+        if (!s->in_use || s->topic != topic || s->depth == 0 || s->last_seq == t->lock.seq) {
+            continue;
+        }
+        if (s->count == s->depth) {
+            s->head = (s->head + 1) % s->depth;
+            s->count--;
+            s->dropped++;
+        }
+        memcpy(&s->samples[((s->head + s->count) % s->depth) * t->size], data, t->size);
+        s->count++;
+    }
+
+    if (earliest != TID_NULL) {
+        preemptIfEarlier(earliest);
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Take the next sample for a subscription, blocking for up to timeout ms
+ *
+ * Queued subscriptions return their oldest sample; latest-value ones
+ * return the latest sample if it hasn't been received yet.
+ * 
+ * @retval RTX_OK once a sample is copied to buf, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int topicReceive(subscription_t sub, void *buf, U32 timeout) {
+    if (sub >= MAX_SUBSCRIPTIONS || !subscriptions[sub].in_use || buf == NULL) {
+        return RTX_ERR;
+    }
+    subscription *s = &subscriptions[sub];
+    struct topic *t = &topics[s->topic];
+
+    if (s->depth > 0 && s->count > 0) {
+        memcpy(buf, &s->samples[s->head * t->size], t->size);
+        s->head = (s->head + 1) % s->depth;
+        s->count--;
+        return RTX_OK;
+    }
+    if (s->depth == 0 && s->last_seq != t->lock.seq) {
+        memcpy(buf, t->latest, t->size);
+        s->last_seq = t->lock.seq;
+        return RTX_OK;
+    }
+
+    int ret = blockTask(&t->waiters, timeout);
+    ktasks[running_task].wait_info = sub;
+    return ret;
+}
+
+/**
+ * @brief Copy a topic's latest sample without blocking or entering the kernel
+ *
+ * Retries if a publish lands while copying, so the result is never torn.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if nothing has been published yet
+ */
+int osTopicRead(topic_t topic, void *buf) {
+    if (topic >= MAX_TOPICS || !topics[topic].in_use || buf == NULL) {
+        return RTX_ERR;
+    }
+    struct topic *t = &topics[topic];
+
+    return osSeqlockRead(&t->lock, buf, t->latest, t->size) == 0 ? RTX_ERR : RTX_OK;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include "k_ring.h"
+#include "k_task.h"
+#include "stm32f401xe.h"
+
+/**
+ * @brief Set up an empty ring over caller-provided storage
+ * 
+ * @retval RTX_OK on success, RTX_ERR if capacity is not a power of two
+ */
+int osRingInit(ringBuffer *ring, U8 *storage, U32 capacity) {
+    if (ring == NULL || storage == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return RTX_ERR;
+    }
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->data = storage;
+    ring->waiters.head = NULL;
+    return RTX_OK;
+}
+
+/**
+ * @brief Append a byte, called only by the single producer (ISR or task)
+ *
+ * The byte is published before head moves, so the consumer never sees a
+ * slot it can't read yet. The kernel is only entered, with interrupts
+ * masked, when the consumer is actually blocked waiting for data.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the ring is full
+ */
+int osRingPut(ringBuffer *ring, U8 byte) {
+    U32 head = ring->head;
+    if (head - ring->tail > ring->mask) {
+        return RTX_ERR;
+    }
+
+    ring->data[head & ring->mask] = byte;
+    __DMB();
+    ring->head = head + 1;
+
+    if (ring->waiters.head != NULL) {
+        U32 primask = __get_PRIMASK();
+        __disable_irq();
+        task_t woken = wakeFirst(&ring->waiters, RTX_OK);
+        if (woken != TID_NULL) {
+            preemptIfEarlier(woken);
+        }
+        __set_PRIMASK(primask);
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Remove a byte without blocking, called only by the single consumer
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the ring is empty
+ */
+int osRingGet(ringBuffer *ring, U8 *byte) {
+    U32 tail = ring->tail;
+    if (tail == ring->head) {
+        return RTX_ERR;
+    }
+
+    __DMB();
+    *byte = ring->data[tail & ring->mask];
+    __DMB();
+    ring->tail = tail + 1;
+    return RTX_OK;
+}
+
+/**
+ * @brief Block the consumer until the ring holds data
+ *
+ * Interrupts are masked between the emptiness check and blocking so a
+ * producer ISR can't slip its wake-up in between.
+ * 
+ * @retval RTX_OK once data is available, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int ringWait(ringBuffer *ring, U32 timeout) {
+    if (ring == NULL) {
+        return RTX_ERR;
+    }
+
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    int ret = RTX_OK;
+    if (ring->tail == ring->head) {
+        ret = blockTask(&ring->waiters, timeout);
+    }
+    __set_PRIMASK(primask);
+    return ret;
+}
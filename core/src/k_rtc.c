@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include "k_rtc.h"
+#include "k_task.h"
+#include "stm32f401xe.h"
+#include "stm32f4xx_hal.h"
+
+extern TCB tasks[MAX_TASKS];
+extern kernelTCB ktasks[MAX_TASKS];
+extern task_t running_task;
+
+static rtcHandler handlers[MAX_RTC_HANDLERS];
+static rtcHandler *pending_head; // activated handlers, earliest due first
+static task_t dispatcher = TID_NULL; // task whose stack every handler runs on
+static waitQueue idle; // dispatcher blocked in rtcNext()
+
+/**
+ * @brief Body of the dispatcher task: run activated handlers one at a time
+ * 
+ * @retval None
+ */
+static void rtcDispatcher(void *args) {
+    workJob job;
+    while (1) {
+        if (osRtcNext(&job) == RTX_OK) {
+            job.fn(job.arg);
+        }
+    }
+}
+
+/**
+ * @brief Register a run-to-completion handler
+ *
+ * The first handler created also creates the dispatcher task and its
+ * RTC_STACK_SIZE stack, which every handler shares. A deadline of 0 means
+ * DEFAULT_DEADLINE.
+ * 
+ * @retval RTX_OK and the handler ID on success, RTX_ERR on failure
+ */
+int rtcCreate(rtc_t *handler, void (*fn)(void *arg), void *arg, U32 deadline) {
+    if (handler == NULL || fn == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_RTC_HANDLERS; i++) {
+        if (!handlers[i].in_use) {
+            if (dispatcher == TID_NULL) {
+                TCB task;
+                task.ptask = rtcDispatcher;
+                task.wcet_ms = 0;
+                task.period = 0;
+                task.stack_size = RTC_STACK_SIZE;
+                if (createTask(&task) != RTX_OK) {
+                    return RTX_ERR;
+                }
+                dispatcher = task.tid;
+            }
+
+            handlers[i].fn = fn;
+            handlers[i].arg = arg;
+            handlers[i].deadline = (deadline != 0) ? deadline : DEFAULT_DEADLINE;
+            handlers[i].pending = 0;
+            handlers[i].in_use = 1;
+            *handler = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Take the earliest pending handler and run the dispatcher under its deadline
+ * 
+ * @retval None
+ */
+static void rtcTake(workJob *job) {
+    rtcHandler *h = pending_head;
+    pending_head = h->next;
+    h->pending = 0;
+
+    job->fn = h->fn;
+    job->arg = h->arg;
+    job->deadline = h->deadline;
+
+    int left = (int)(h->due - HAL_GetTick());
+    retimeTask(dispatcher, h->deadline, (left > 0) ? (U32)left : 1);
+}
+
+/**
+ * @brief Activate a handler, from a task or an ISR
+ *
+ * Must be called with interrupts masked. Activating a handler that is
+ * already pending does nothing. Handlers never preempt one another: if
+ * the dispatcher is busy, it instead takes on the new activation's
+ * deadline when that is earlier, so the running handler finishes before
+ * any task less urgent than the pending one gets the CPU. The stack
+ * therefore only ever holds one handler, as with every handler at one
+ * SRP preemption level.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if handler is invalid
+ */
+int rtcPost(rtc_t handler) {
+    if (handler >= MAX_RTC_HANDLERS || !handlers[handler].in_use) {
+        return RTX_ERR;
+    }
+
+    rtcHandler *h = &handlers[handler];
+    if (h->pending) {
+        return RTX_OK;
+    }
+    h->pending = 1;
+    h->due = HAL_GetTick() + h->deadline;
+
+    rtcHandler **link = &pending_head;
+    while (*link != NULL && (int)((*link)->due - h->due) <= 0) {
+        link = &(*link)->next;
+    }
+    h->next = *link;
+    *link = h;
+
+    if (tasks[dispatcher].state == BLOCKED && idle.head != NULL) {
+        // The job pointer was kept in wait_info when the dispatcher blocked
+        rtcTake((workJob *)ktasks[dispatcher].wait_info);
+        wakeTask(dispatcher, RTX_OK);
+        preemptIfEarlier(dispatcher);
+    } else if (h->deadline < tasks[dispatcher].time_left) {
+        retimeTask(dispatcher, tasks[dispatcher].deadline, h->deadline);
+        if (tasks[dispatcher].state == READY) {
+            preemptIfEarlier(dispatcher);
+        }
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Fetch the next handler for the dispatcher, parking it until one is activated
+ * 
+ * @retval RTX_OK with the job filled in, RTX_ERR if the caller is not the dispatcher
+ */
+int rtcNext(workJob *job) {
+    if (job == NULL || running_task == TID_NULL || running_task != dispatcher) {
+        return RTX_ERR;
+    }
+
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    int ret = RTX_OK;
+    if (pending_head == NULL) {
+        ret = blockTask(&idle, OS_WAIT_FOREVER);
+        ktasks[running_task].wait_info = (U32)job;
+    } else {
+        rtcTake(job);
+        reschedule();
+    }
+    __set_PRIMASK(primask);
+    return ret;
+}
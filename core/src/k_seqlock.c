@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include "k_seqlock.h"
+#include "stm32f401xe.h"
+
+/**
+ * @brief Initialize a seqlock with no write in progress
+ * 
+ * @retval None
+ */
+void osSeqlockInit(seqlock *lock) {
+    lock->seq = 0;
+}
+
+/**
+ * @brief Mark the start of a write. Writers must be serialized by the caller
+ * 
+ * @retval None
+ */
+void osSeqlockWriteBegin(seqlock *lock) {
+    lock->seq++;
+    __DMB();
+}
+
+/**
+ * @brief Mark the end of a write, publishing it to readers
+ * 
+ * @retval None
+ */
+void osSeqlockWriteEnd(seqlock *lock) {
+    __DMB();
+    lock->seq++;
+}
+
+/**
+ * @brief Start a read section
+ * 
+ * @retval Sequence value to pass to osSeqlockReadRetry()
+ */
+U32 osSeqlockReadBegin(seqlock *lock) {
+    U32 start = lock->seq;
+    __DMB();
+    return start;
+}
+
+/**
+ * @brief Check whether a read section overlapped a write
+ * 
+ * @retval 1 if the data read may be torn and must be read again, 0 otherwise
+ */
+int osSeqlockReadRetry(seqlock *lock, U32 start) {
+    __DMB();
+    return (start & 1) || lock->seq != start;
+}
+
+/**
+ * @brief Copy size bytes into seqlock-protected storage
+ * 
+ * @retval None
+ */
+void osSeqlockWrite(seqlock *lock, void *dst, const void *src, U32 size) {
+    osSeqlockWriteBegin(lock);
+    memcpy(dst, src, size);
+    osSeqlockWriteEnd(lock);
+}
+
+/**
+ * @brief Copy size bytes out of seqlock-protected storage, retrying until consistent
+ *
+ * A reader preempted by the writer simply copies again, so this never
+ * blocks the writer. A reader must not preempt a writer task mid-write
+ * and spin here, so tasks that write should do so at an urgency no lower
+ * than the readers, or from an ISR.
+ * 
+ * @retval Sequence value of the copy, 0 if nothing has been written yet
+ */
+U32 osSeqlockRead(seqlock *lock, void *dst, const void *src, U32 size) {
+    U32 start;
+    do {
+        start = osSeqlockReadBegin(lock);
+        memcpy(dst, src, size);
+    } while (osSeqlockReadRetry(lock, start));
+    return start;
+}
+
+/**
+ * @brief Set up a triple buffer over caller-provided storage of 3 * size bytes
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int osTripleInit(tripleBuffer *buffer, U8 *storage, U32 size) {
+    if (buffer == NULL || storage == NULL || size == 0) {
+        return RTX_ERR;
+    }
+
+    buffer->data = storage;
+    buffer->size = size;
+    buffer->back = 0;
+    buffer->state = 1;
+    buffer->front = 2;
+    return RTX_OK;
+}
+
+/**
+ * @brief Get the buffer the single writer should fill next
+ * 
+ * @retval Pointer to size bytes owned by the writer until osTriplePublish()
+ */
+void * osTripleWriteBuffer(tripleBuffer *buffer) {
+    return &buffer->data[buffer->back * buffer->size];
+}
+
+/**
+ * @brief Publish the filled buffer as the latest and take the stale one back
+ * 
+ * @retval None
+ */
+void osTriplePublish(tripleBuffer *buffer) {
+    U32 old;
+    __DMB();
+    do {
+        old = __LDREXW(&buffer->state);
+    } while (__STREXW(buffer->back | TRIPLE_FRESH, &buffer->state) != 0);
+    buffer->back = old & TRIPLE_INDEX;
+}
+
+/**
+ * @brief Get the latest published buffer for the single reader
+ *
+ * If something was published since the last call, the reader swaps it in;
+ * otherwise it keeps the buffer it already has. The writer never touches
+ * the returned buffer until the next call.
+ * 
+ * @retval Pointer to the reader's buffer, with *fresh set to 1 if it is new
+ */
+void * osTripleRead(tripleBuffer *buffer, int *fresh) {
+    int swapped = 0;
+    if (buffer->state & TRIPLE_FRESH) {
+        U32 old;
+        do {
+            old = __LDREXW(&buffer->state);
+        } while (__STREXW(buffer->front, &buffer->state) != 0);
+        __DMB();
+        buffer->front = old & TRIPLE_INDEX;
+        swapped = 1;
+    }
+    if (fresh != NULL) {
+        *fresh = swapped;
+    }
+    return &buffer->data[buffer->front * buffer->size];
+}
@@ -0,0 +1,787 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "k_sync.h"
+#include "k_task.h"
+#include "stm32f401xe.h"
+
+extern TCB tasks[MAX_TASKS];
+extern kernelTCB ktasks[MAX_TASKS];
+extern task_t running_task;
+
+static semaphore sems[MAX_SEMAPHORES];
+static mutex mutexes[MAX_MUTEXES];
+static futex futexes[MAX_FUTEXES];
+static eventGroup events[MAX_EVENTS];
+static condVar condvars[MAX_CONDVARS];
+static rwLockWaiters rwlocks[MAX_RWLOCKS];
+static barrier barriers[MAX_BARRIERS];
+
+/**
+ * @brief Allocate a counting semaphore with an initial count
+ * 
+ * @retval RTX_OK and the semaphore ID on success, RTX_ERR if none are free
+ */
+int semCreate(semaphore_t *sem, U32 count) {
+    if (sem == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_SEMAPHORES; i++) {
+        if (!sems[i].in_use) {
+            sems[i].in_use = 1;
+            sems[i].count = count;
+            sems[i].waiters.head = NULL;
+            *sem = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Take one unit from a semaphore, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK once a unit is taken, RTX_TIMEOUT if none arrived in time, RTX_ERR on failure
+ */
+int semWait(semaphore_t sem, U32 timeout) {
+    if (sem >= MAX_SEMAPHORES || !sems[sem].in_use) {
+        return RTX_ERR;
+    }
+
+    if (sems[sem].count > 0) {
+        sems[sem].count--;
+        return RTX_OK;
+    }
+    return blockTask(&sems[sem].waiters, timeout);
+}
+
+/**
+ * @brief Give one unit to a semaphore
+ *
+ * The unit goes straight to the most urgent waiter if there is one, and
+ * PendSV is only triggered if that waiter should preempt the caller.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int semPost(semaphore_t sem) {
+    if (sem >= MAX_SEMAPHORES || !sems[sem].in_use) {
+        return RTX_ERR;
+    }
+
+    task_t woken = wakeFirst(&sems[sem].waiters, RTX_OK);
+    if (woken != TID_NULL) {
+        preemptIfEarlier(woken);
+        return RTX_OK;
+    }
+
+    if (sems[sem].count == UINT32_MAX) {
+        return RTX_ERR;
+    }
+    sems[sem].count++;
+    return RTX_OK;
+}
+
+/**
+ * @brief Find the mutex that owns a wait queue
+ * 
+ * @retval Pointer to the mutex, NULL if the queue belongs to another object
+ */
+static mutex *mutexOf(waitQueue *queue) {
+    for (int i = 0; i < MAX_MUTEXES; i++) {
+        if (&mutexes[i].waiters == queue) {
+            return &mutexes[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Recompute the deadline a task inherits from the mutexes it holds
+ *
+ * The task inherits the earliest effective deadline among the first
+ * waiters of every mutex it owns. If the task is itself blocked on a
+ * mutex, its new deadline moves it within that queue and is passed on to
+ * that mutex's owner, and so on down the chain.
+ * 
+ * @retval None
+ */
+static void updateInheritance(task_t tid) {
+    for (int depth = 0; tid != TID_NULL && depth < MAX_TASKS; depth++) {
+        U32 inherit = 0;
+        for (int i = 0; i < MAX_MUTEXES; i++) {
+            if (mutexes[i].in_use && mutexes[i].owner == tid && mutexes[i].waiters.head != NULL) {
+                U32 key = taskKey(mutexes[i].waiters.head->tid);
+                if (inherit == 0 || key < inherit) {
+                    inherit = key;
+                }
+            }
+        }
+        if (ktasks[tid].inherit_left == inherit) {
+            return;
+        }
+        ktasks[tid].inherit_left = inherit;
+        keyChanged(tid);
+
+        if (tasks[tid].state != BLOCKED) {
+            return;
+        }
+        mutex *next = mutexOf(ktasks[tid].wait_queue);
+        if (next == NULL) {
+            return;
+        }
+        requeueTask(tid);
+        tid = next->owner;
+    }
+}
+
+/**
+ * @brief Allocate an unlocked mutex
+ * 
+ * @retval RTX_OK and the mutex ID on success, RTX_ERR if none are free
+ */
+int mutexCreate(mutex_t *mutex) {
+    if (mutex == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_MUTEXES; i++) {
+        if (!mutexes[i].in_use) {
+            mutexes[i].in_use = 1;
+            mutexes[i].owner = TID_NULL;
+            mutexes[i].lock_count = 0;
+            mutexes[i].waiters.head = NULL;
+            *mutex = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Lock a mutex, blocking for up to timeout ms
+ *
+ * The owner may lock again, and must unlock as many times. While the caller
+ * waits, the owner inherits the caller's deadline if it is earlier.
+ * 
+ * @retval RTX_OK once locked, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int mutexLock(mutex_t mutex, U32 timeout) {
+    if (mutex >= MAX_MUTEXES || !mutexes[mutex].in_use || running_task == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    struct mutex *m = &mutexes[mutex];
+    if (m->owner == TID_NULL) {
+        m->owner = running_task;
+        m->lock_count = 1;
+        return RTX_OK;
+    }
+    if (m->owner == running_task) {
+        if (m->lock_count == UINT32_MAX) {
+            return RTX_ERR;
+        }
+        m->lock_count++;
+        return RTX_OK;
+    }
+
+    int ret = blockTask(&m->waiters, timeout);
+    if (ret == RTX_TIMEOUT && tasks[running_task].state == BLOCKED) {
+        updateInheritance(m->owner);
+        // The boosted owner may now be the earliest task
+        scheduler();
+    }
+    return ret;
+}
+
+/**
+ * @brief Pass a mutex the running task has fully unlocked to its most urgent waiter
+ *
+ * The caller drops any deadline it inherited through this mutex. Leaves
+ * rescheduling to the caller.
+ * 
+ * @retval None
+ */
+static void mutexRelease(struct mutex *m) {
+    task_t woken = wakeFirst(&m->waiters, RTX_OK);
+    m->owner = woken;
+    if (woken != TID_NULL) {
+        m->lock_count = 1;
+        updateInheritance(woken);
+    }
+    updateInheritance(running_task);
+}
+
+/**
+ * @brief Unlock a mutex held by the caller
+ *
+ * On the final unlock ownership passes directly to the most urgent waiter,
+ * and the caller drops any deadline it inherited through this mutex.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the caller is not the owner
+ */
+int mutexUnlock(mutex_t mutex) {
+    if (mutex >= MAX_MUTEXES || !mutexes[mutex].in_use || running_task == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    struct mutex *m = &mutexes[mutex];
+    if (m->owner != running_task) {
+        return RTX_ERR;
+    }
+    if (--m->lock_count > 0) {
+        return RTX_OK;
+    }
+
+    mutexRelease(m);
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Block on a user word as long as it still holds the expected value
+ *
+ * The check and the block happen inside one SVC, so a wake issued after the
+ * caller last looked at the word can't be missed.
+ * 
+ * @retval RTX_OK if woken or the word already changed, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int futexWait(volatile U32 *addr, U32 expected, U32 timeout) {
+    if (addr == NULL) {
+        return RTX_ERR;
+    }
+    if (*addr != expected) {
+        return RTX_OK;
+    }
+
+    futex *slot = NULL;
+    for (int i = 0; i < MAX_FUTEXES; i++) {
+        if (futexes[i].waiters.head != NULL && futexes[i].addr == addr) {
+            slot = &futexes[i];
+            break;
+        }
+        if (slot == NULL && futexes[i].waiters.head == NULL) {
+            slot = &futexes[i];
+        }
+    }
+    if (slot == NULL) {
+        return RTX_ERR;
+    }
+
+    slot->addr = addr;
+    return blockTask(&slot->waiters, timeout);
+}
+
+/**
+ * @brief Wake up to count tasks blocked on a user word, most urgent first
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int futexWake(volatile U32 *addr, U32 count) {
+    if (addr == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_FUTEXES; i++) {
+        if (futexes[i].waiters.head != NULL && futexes[i].addr == addr) {
+            while (count-- > 0) {
+                task_t woken = wakeFirst(&futexes[i].waiters, RTX_OK);
+                if (woken == TID_NULL) {
+                    break;
+                }
+                preemptIfEarlier(woken);
+            }
+            break;
+        }
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Allocate an event flag group with every flag clear
+ * 
+ * @retval RTX_OK and the group ID on success, RTX_ERR if none are free
+ */
+int eventCreate(event_t *event) {
+    if (event == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        if (!events[i].in_use) {
+            events[i].in_use = 1;
+            events[i].flags = 0;
+            events[i].waiters.head = NULL;
+            *event = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Check whether a set of flags satisfies a wait
+ * 
+ * @retval 1 if the waiter may proceed, 0 otherwise
+ */
+static int eventMatches(U32 flags, U32 mask, U32 mode) {
+    if (mode & EVENT_WAIT_ALL) {
+        return (flags & mask) == mask;
+    }
+    return (flags & mask) != 0;
+}
+
+/**
+ * @brief Set flags and wake every waiter they satisfy
+ *
+ * Safe to call from an ISR. Waiters are checked in deadline order, so one
+ * that consumes flags with EVENT_CLEAR does so before less urgent ones see
+ * them. Every satisfied waiter is made ready in this one pass and PendSV is
+ * triggered at most once, for the most urgent of them.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int eventSet(event_t event, U32 mask) {
+    if (event >= MAX_EVENTS || !events[event].in_use) {
+        return RTX_ERR;
+    }
+
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    eventGroup *group = &events[event];
+    group->flags |= mask;
+
+    task_t earliest = TID_NULL;
+    TCB *waiter = group->waiters.head;
+    while (waiter != NULL) {
+        TCB *next = ktasks[waiter->tid].wait_next;
+        // The waiter's mask and mode are still in r1 and r2 of its blocked SVC
+        U32 wait_mask = ktasks[waiter->tid].wait_frame[1];
+        U32 wait_mode = ktasks[waiter->tid].wait_frame[2];
+        if (eventMatches(group->flags, wait_mask, wait_mode)) {
+            if (wait_mode & EVENT_CLEAR) {
+                group->flags &= ~wait_mask;
+            }
+            if (earliest == TID_NULL) {
+                earliest = waiter->tid;
+            }
+            wakeTask(waiter->tid, RTX_OK);
+        }
+        waiter = next;
+    }
+
+    if (earliest != TID_NULL) {
+        preemptIfEarlier(earliest);
+    }
+    __set_PRIMASK(primask);
+    return RTX_OK;
+}
+
+/**
+ * @brief Clear flags without waking anyone
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int eventClear(event_t event, U32 mask) {
+    if (event >= MAX_EVENTS || !events[event].in_use) {
+        return RTX_ERR;
+    }
+
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    events[event].flags &= ~mask;
+    __set_PRIMASK(primask);
+    return RTX_OK;
+}
+
+/**
+ * @brief Wait for any or all flags in mask, blocking for up to timeout ms
+ * 
+ * @retval RTX_OK once satisfied, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int eventWait(event_t event, U32 mask, U32 mode, U32 timeout) {
+    if (event >= MAX_EVENTS || !events[event].in_use || mask == 0) {
+        return RTX_ERR;
+    }
+
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    eventGroup *group = &events[event];
+    int ret;
+    if (eventMatches(group->flags, mask, mode)) {
+        if (mode & EVENT_CLEAR) {
+            group->flags &= ~mask;
+        }
+        ret = RTX_OK;
+    } else {
+        ret = blockTask(&group->waiters, timeout);
+    }
+    __set_PRIMASK(primask);
+    return ret;
+}
+
+/**
+ * @brief Allocate a condition variable
+ * 
+ * @retval RTX_OK and the condition variable ID on success, RTX_ERR if none are free
+ */
+int condCreate(cond_t *cond) {
+    if (cond == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_CONDVARS; i++) {
+        if (!condvars[i].in_use) {
+            condvars[i].in_use = 1;
+            condvars[i].waiters.head = NULL;
+            *cond = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Atomically unlock a mutex and wait on a condition variable
+ *
+ * The caller must hold the mutex exactly once. A signalled waiter returns
+ * with the mutex held again. A waiter that times out returns RTX_TIMEOUT
+ * without it; osCondWait() re-locks before returning to the task.
+ * 
+ * @retval RTX_OK once signalled and re-locked, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int condWait(cond_t cond, mutex_t mutex, U32 timeout) {
+    if (cond >= MAX_CONDVARS || !condvars[cond].in_use || mutex >= MAX_MUTEXES || !mutexes[mutex].in_use) {
+        return RTX_ERR;
+    }
+
+    struct mutex *m = &mutexes[mutex];
+    if (running_task == TID_NULL || m->owner != running_task || m->lock_count != 1 || timeout == 0) {
+        return RTX_ERR;
+    }
+
+    m->lock_count = 0;
+    mutexRelease(m);
+    return blockTask(&condvars[cond].waiters, timeout);
+}
+
+/**
+ * @brief Move a condition variable waiter over to its mutex
+ *
+ * Rather than waking the waiter only for it to block again on a mutex that
+ * is still held, it is queued on the mutex directly and only becomes ready
+ * once it owns it.
+ * 
+ * @retval TID of the waiter if it was granted the mutex and woken, TID_NULL otherwise
+ */
+static task_t condMorph(TCB *waiter) {
+    task_t tid = waiter->tid;
+    // The mutex is still in r1 of the waiter's blocked SVC
+    struct mutex *m = &mutexes[ktasks[waiter->tid].wait_frame[1]];
+
+    if (m->owner == TID_NULL) {
+        m->owner = tid;
+        m->lock_count = 1;
+        wakeTask(tid, RTX_OK);
+        updateInheritance(tid);
+        return tid;
+    }
+
+    moveWaiter(tid, &m->waiters, OS_WAIT_FOREVER);
+    updateInheritance(m->owner);
+    return TID_NULL;
+}
+
+/**
+ * @brief Release the most urgent waiter of a condition variable
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int condSignal(cond_t cond) {
+    if (cond >= MAX_CONDVARS || !condvars[cond].in_use) {
+        return RTX_ERR;
+    }
+
+    TCB *waiter = condvars[cond].waiters.head;
+    if (waiter != NULL) {
+        task_t woken = condMorph(waiter);
+        if (woken != TID_NULL) {
+            preemptIfEarlier(woken);
+        }
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Release every waiter of a condition variable
+ *
+ * Waiters are handed over to their mutex in deadline order, so at most one
+ * of them becomes ready and the rest stay blocked until it is their turn
+ * to own the mutex, with no herd of context switches.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int condBroadcast(cond_t cond) {
+    if (cond >= MAX_CONDVARS || !condvars[cond].in_use) {
+        return RTX_ERR;
+    }
+
+    task_t earliest = TID_NULL;
+    while (condvars[cond].waiters.head != NULL) {
+        task_t woken = condMorph(condvars[cond].waiters.head);
+        if (earliest == TID_NULL) {
+            earliest = woken;
+        }
+    }
+    if (earliest != TID_NULL) {
+        preemptIfEarlier(earliest);
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Register a readers-writer lock and set it unlocked
+ * 
+ * @retval RTX_OK on success, RTX_ERR if none are free
+ */
+int rwLockCreate(rwLock *lock) {
+    if (lock == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_RWLOCKS; i++) {
+        if (rwlocks[i].state == NULL) {
+            rwlocks[i].state = &lock->state;
+            rwlocks[i].readers.head = NULL;
+            rwlocks[i].writers.head = NULL;
+            lock->state = 0;
+            lock->id = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Hand a readers-writer lock to its waiters once it allows it
+ *
+ * A waiting writer gets the lock as soon as the last holder leaves, unless
+ * waiting readers have more urgent deadlines, in which case only those
+ * readers are let in. Readers never get in ahead of a writer while the lock
+ * is held. RWLOCK_WAITING is kept set exactly while someone is queued. The
+ * SVCs that touch the word already cleared every exclusive monitor, so plain
+ * stores are safe against the user-side LDREX/STREX paths.
+ * 
+ * @retval TID of the most urgent task woken, TID_NULL if none
+ */
+static task_t rwLockHandoff(rwLockWaiters *l) {
+    U32 state = *l->state;
+    task_t woken = TID_NULL;
+
+    if (!(state & RWLOCK_WRITER)) {
+        TCB *writer = l->writers.head;
+        TCB *reader = l->readers.head;
+        if (writer != NULL && (state & RWLOCK_READERS) == 0
+                && (reader == NULL || taskKey(writer->tid) <= taskKey(reader->tid))) {
+            woken = wakeFirst(&l->writers, RTX_OK);
+            state |= RWLOCK_WRITER;
+        } else if (writer == NULL || (state & RWLOCK_READERS) == 0) {
+            // With a writer queued, only readers more urgent than it go first
+            U32 limit = (writer != NULL) ? taskKey(writer->tid) : UINT32_MAX;
+            while (l->readers.head != NULL && (writer == NULL || taskKey(l->readers.head->tid) < limit)
+                    && (state & RWLOCK_READERS) != RWLOCK_READERS) {
+                task_t tid = wakeFirst(&l->readers, RTX_OK);
+                if (woken == TID_NULL) {
+                    woken = tid;
+                }
+                state++;
+            }
+        }
+    }
+
+    if (l->readers.head != NULL || l->writers.head != NULL) {
+        state |= RWLOCK_WAITING;
+    } else {
+        state &= ~RWLOCK_WAITING;
+    }
+    *l->state = state;
+    return woken;
+}
+
+/**
+ * @brief Contended path of osRwLockRead(), blocking for up to timeout ms
+ *
+ * The caller gets in unless a writer holds the lock or is waiting for it.
+ * 
+ * @retval RTX_OK once held, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int rwLockRead(U32 id, U32 timeout) {
+    if (id >= MAX_RWLOCKS || rwlocks[id].state == NULL) {
+        return RTX_ERR;
+    }
+
+    rwLockWaiters *l = &rwlocks[id];
+    U32 state = *l->state;
+    if (!(state & RWLOCK_WRITER) && l->writers.head == NULL) {
+        if ((state & RWLOCK_READERS) == RWLOCK_READERS) {
+            return RTX_ERR;
+        }
+        *l->state = state + 1;
+        return RTX_OK;
+    }
+
+    *l->state = state | RWLOCK_WAITING;
+    return blockTask(&l->readers, timeout);
+}
+
+/**
+ * @brief Contended path of osRwLockWrite(), blocking for up to timeout ms
+ * 
+ * @retval RTX_OK once held, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int rwLockWrite(U32 id, U32 timeout) {
+    if (id >= MAX_RWLOCKS || rwlocks[id].state == NULL) {
+        return RTX_ERR;
+    }
+
+    rwLockWaiters *l = &rwlocks[id];
+    U32 state = *l->state;
+    if ((state & ~RWLOCK_WAITING) == 0) {
+        *l->state = state | RWLOCK_WRITER;
+        return RTX_OK;
+    }
+
+    *l->state = state | RWLOCK_WAITING;
+    return blockTask(&l->writers, timeout);
+}
+
+/**
+ * @brief Contended path of osRwLockUnlock(), handing the lock to its waiters
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the lock was not held
+ */
+int rwLockUnlock(U32 id) {
+    if (id >= MAX_RWLOCKS || rwlocks[id].state == NULL) {
+        return RTX_ERR;
+    }
+
+    rwLockWaiters *l = &rwlocks[id];
+    U32 state = *l->state;
+    if (state & RWLOCK_WRITER) {
+        state &= ~RWLOCK_WRITER;
+    } else if (state & RWLOCK_READERS) {
+        state--;
+    } else {
+        return RTX_ERR;
+    }
+    *l->state = state;
+
+    rwLockHandoff(l);
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Find the readers-writer lock whose writers wait on a queue
+ * 
+ * @retval Pointer to the lock, NULL if the queue belongs to another object
+ */
+static rwLockWaiters *rwLockOf(waitQueue *queue) {
+    for (int i = 0; i < MAX_RWLOCKS; i++) {
+        if (&rwlocks[i].writers == queue) {
+            return &rwlocks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Allocate a barrier released once parties tasks have arrived
+ * 
+ * @retval RTX_OK and the barrier ID on success, RTX_ERR if none are free
+ */
+int barrierCreate(barrier_t *b, U32 parties) {
+    if (b == NULL || parties == 0) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_BARRIERS; i++) {
+        if (!barriers[i].in_use) {
+            barriers[i].in_use = 1;
+            barriers[i].parties = parties;
+            barriers[i].arrived = 0;
+            barriers[i].waiters.head = NULL;
+            *b = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Wait at a barrier until every party has arrived, blocking for up to timeout ms
+ *
+ * The last task to arrive releases the others and the barrier resets for
+ * the next round. A task that times out no longer counts as arrived.
+ * 
+ * @retval RTX_OK once released, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int barrierWait(barrier_t b, U32 timeout) {
+    if (b >= MAX_BARRIERS || !barriers[b].in_use || running_task == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    barrier *bar = &barriers[b];
+    if (bar->arrived + 1 < bar->parties) {
+        if (timeout == 0) {
+            return RTX_TIMEOUT;
+        }
+        bar->arrived++;
+        return blockTask(&bar->waiters, timeout);
+    }
+
+    bar->arrived = 0;
+    while (wakeFirst(&bar->waiters, RTX_OK) != TID_NULL) {
+    }
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Find the barrier that owns a wait queue
+ * 
+ * @retval Pointer to the barrier, NULL if the queue belongs to another object
+ */
+static barrier *barrierOf(waitQueue *queue) {
+    for (int i = 0; i < MAX_BARRIERS; i++) {
+        if (&barriers[i].waiters == queue) {
+            return &barriers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Undo the effects of a waiter leaving a queue without being granted
+ *
+ * Called after a blocked task times out, so an owner that was running on
+ * that task's deadline can fall back to its own.
+ * 
+ * @retval None
+ */
+void waitAborted(waitQueue *queue) {
+    mutex *m = mutexOf(queue);
+    if (m != NULL) {
+        updateInheritance(m->owner);
+    }
+
+    // Readers held back by a writer that gave up may now get in
+    rwLockWaiters *l = rwLockOf(queue);
+    if (l != NULL) {
+        rwLockHandoff(l);
+    }
+
+    barrier *bar = barrierOf(queue);
+    if (bar != NULL) {
+        bar->arrived--;
+    }
+}
@@ -3,31 +3,90 @@
 #include "stm32f401xe.h"
 #include "stm32f4xx_hal.h"
 #include "k_mem.h"
+#include "k_sync.h"
 
 TCB tasks[MAX_TASKS];
+kernelTCB ktasks[MAX_TASKS]; // kernel-only state of each task, kept out of the TCB users see
 task_t running_task;
 task_t selected_task;
 U8 num_tasks;
 U32 *MSP_INIT_VAL;
 U8 kernel_init_done = 0;
+U8 kernel_started = 0;
 volatile U32 stackptr;
 volatile U32 *pendsv_reg;
 
+static waitQueue joiners[MAX_TASKS]; // tasks blocked in taskJoin() on each task
+static U8 detached[MAX_TASKS]; // 1 if the task's slot is recycled without a join
+static int exit_status[MAX_TASKS]; // value passed to taskExit(), kept until joined
+static taskGroup groups[MAX_GROUPS];
+static group_t task_group[MAX_TASKS]; // group the task belongs to, GROUP_NONE if in none
+static reservation reservations[MAX_TASKS]; // CBS reservation of each task
+static execBudget budgets[MAX_TASKS]; // WCET budget of each task
+static U32 charged_at; // DWT cycle count the running task was last charged up to
+
+static U8 sched_class[MAX_TASKS]; // SCHED_REALTIME or SCHED_BACKGROUND
+static U32 bg_ready; // bit 31 - tid set for each ready background task
+static task_t bg_cursor; // background task holding the current timeslice
+static U32 bg_slice; // ticks left in the current background timeslice
+static U32 lent_left[MAX_TASKS]; // key lent by a task that yielded to us with osYieldTo(), 0 if none
+
+#if SCHED_FIXED_PRIORITY
+static U32 ready_levels; // bit 31 - p set while any task is ready at level p
+static U32 level_tasks[FP_LEVELS]; // bit 31 - tid set for each ready task filed at the level
+static U8 task_level[MAX_TASKS]; // level a ready task is filed under
+static U32 priorities[MAX_TASKS]; // level set by setPriority(), or FP_AUTO
+static U8 base_level[MAX_TASKS]; // level the task runs at when nothing is inherited
+#endif
+
+/**
+ * @brief Body of the null task, which runs whenever no other task is ready
+ * 
+ * @retval None
+ */
+static void idleTask(void *args) {
+    while (1) {
+    }
+}
+
+/**
+ * @brief Build an initial exception frame for a task entry point
+ * 
+ * @retval Stack pointer to store in the task's TCB
+ */
+static U32 initStackFrame(U32 stack_high, void (*ptask)(void *args)) {
+    U32 *tmp_stack = (U32 *)stack_high;
+    *(--tmp_stack) = 1 << 24;
+    *(--tmp_stack) = (U32)ptask;
+    for (int i = 0; i < 14; i++) {
+        *(--tmp_stack) = 0xA;
+    }
+    return (U32)tmp_stack;
+}
+
 /**
  * @brief Initialize kernel data structures
  * 
  * @retval None
  */
 void kernelInit(void) {
-    // First thread stack address
-    MSP_INIT_VAL = *(U32**)0x0;
+    // First thread stack address, the first entry of the vector table
+    MSP_INIT_VAL = *(U32**)SCB->VTOR;
 
     // Initialize TCB array
     for (int i = 0; i < MAX_TASKS; i++) {
         tasks[i].tid = TID_NULL;
+        task_group[i] = GROUP_NONE;
     }
     tasks[TID_NULL].stack_high = (U32)((char *)MSP_INIT_VAL - MAIN_STACK_SIZE);
     tasks[TID_NULL].stack_size = THREAD_STACK_SIZE;
+    tasks[TID_NULL].ptask = idleTask;
+
+    // Start the cycle counter used for execution budgets
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    charged_at = 0;
 
     // Initialize global vars
     running_task = TID_NULL;
@@ -50,7 +109,316 @@ void copy_TCB(TCB *tcb1, TCB *tcb2) {
     tcb2->stackptr = tcb1->stackptr;
     tcb2->deadline = tcb1->deadline;
     tcb2->time_left = tcb1->time_left;
+    tcb2->wcet_ms = tcb1->wcet_ms;
+    tcb2->period = tcb1->period;
+}
+
+/**
+ * @brief Key a task is scheduled by on its own, before any it inherited,
+ * was donated or was lent
+ * 
+ * @retval Time left to the task's deadline, priority level + 1 under SCHED_FIXED_PRIORITY
+ */
+static U32 ownKey(task_t tid) {
+    if (sched_class[tid] == SCHED_BACKGROUND) {
+        return BACKGROUND_KEY;
+    }
+#if SCHED_FIXED_PRIORITY
+    return base_level[tid] + 1;
+#else
+    return tasks[tid].time_left;
+#endif
+}
+
+/**
+ * @brief Remaining time used to order a task under EDF
+ *
+ * A task holding a mutex runs on the earliest deadline among the tasks
+ * blocked on it, and a server runs on the earliest deadline among its
+ * clients, if that is earlier than its own. Under SCHED_FIXED_PRIORITY the
+ * key is the task's priority level + 1 instead, and is inherited the same
+ * way. Background tasks sort after every real-time task until they
+ * inherit or are donated a real-time key. A task yielded to with
+ * osYieldTo() also runs on the yielding task's key until it gives up the
+ * CPU.
+ * 
+ * @retval Effective time left to the task's deadline, UINT32_MAX for the null task
+ */
+U32 taskKey(task_t tid) {
+    if (tid == TID_NULL) {
+        return UINT32_MAX;
+    }
+    U32 key = ownKey(tid);
+    if (lent_left[tid] != 0 && lent_left[tid] < key) {
+        key = lent_left[tid];
+    }
+    if (ktasks[tid].inherit_left != 0 && ktasks[tid].inherit_left < key) {
+        key = ktasks[tid].inherit_left;
+    }
+    if (ktasks[tid].donated_left != 0 && ktasks[tid].donated_left < key) {
+        key = ktasks[tid].donated_left;
+    }
+    return key;
+}
+
+/**
+ * @brief Check whether a task is scheduled round-robin in the background class
+ *
+ * A background task that inherited or was donated a real-time key is
+ * scheduled as real-time until it gives it back.
+ * 
+ * @retval 1 if it is, 0 otherwise
+ */
+static U8 inBackground(task_t tid) {
+    return sched_class[tid] == SCHED_BACKGROUND && taskKey(tid) == BACKGROUND_KEY;
+}
+
+/**
+ * @brief File a ready task in the ready structure of its class
+ *
+ * Background tasks go in the round-robin mask. Real-time tasks go in the
+ * fixed-priority bitmap at their effective level; under EDF they need no
+ * filing.
+ * 
+ * @retval None
+ */
+static void readyInsert(task_t tid) {
+    if (inBackground(tid)) {
+        bg_ready |= 1U << (31 - tid);
+        return;
+    }
+#if SCHED_FIXED_PRIORITY
+    U32 level = taskKey(tid) - 1;
+    task_level[tid] = level;
+    level_tasks[level] |= 1U << (31 - tid);
+    ready_levels |= 1U << (31 - level);
+#endif
+}
+
+/**
+ * @brief Take a task out of whichever ready structure holds it
+ * 
+ * @retval None
+ */
+static void readyRemove(task_t tid) {
+    bg_ready &= ~(1U << (31 - tid));
+#if SCHED_FIXED_PRIORITY
+    U32 level = task_level[tid];
+    level_tasks[level] &= ~(1U << (31 - tid));
+    if (level_tasks[level] == 0) {
+        ready_levels &= ~(1U << (31 - level));
+    }
+#endif
+}
+
+/**
+ * @brief Pick the background task to run once no real-time task is ready
+ *
+ * The task holding the timeslice keeps the CPU until the slice runs out or
+ * it stops being ready, then the next ready background task by TID, wrapping
+ * around, gets a fresh slice.
+ * 
+ * @retval TID of the background task to run
+ */
+static task_t backgroundPick(void) {
+    if (bg_slice == 0 || !(bg_ready & (1U << (31 - bg_cursor)))) {
+        U32 later = bg_ready & ((1U << (31 - bg_cursor)) - 1);
+        bg_cursor = __CLZ((later != 0) ? later : bg_ready);
+        bg_slice = RR_TIMESLICE;
+    }
+    return bg_cursor;
+}
+
+#if SCHED_FIXED_PRIORITY
+/**
+ * @brief Recompute every task's base level and refile the ready tasks
+ *
+ * Tasks without an explicit priority are ranked rate-monotonically: the
+ * level is the number of such tasks with a strictly shorter period (the
+ * declared period, or the deadline if none), so equal periods share a
+ * level. Called whenever a task or period comes or goes.
+ * 
+ * @retval None
+ */
+static void rankPriorities(void) {
+    for (task_t i = 1; i < MAX_TASKS; i++) {
+        if (tasks[i].tid == TID_NULL) {
+            continue;
+        }
+        if (priorities[i] != FP_AUTO) {
+            base_level[i] = priorities[i];
+            continue;
+        }
+        U32 period = (tasks[i].period != 0) ? tasks[i].period : tasks[i].deadline;
+        U32 rank = 0;
+        for (task_t j = 1; j < MAX_TASKS; j++) {
+            if (j != i && tasks[j].tid != TID_NULL && priorities[j] == FP_AUTO
+                && sched_class[j] == SCHED_REALTIME) {
+                U32 other = (tasks[j].period != 0) ? tasks[j].period : tasks[j].deadline;
+                if (other < period) {
+                    rank++;
+                }
+            }
+        }
+        base_level[i] = (rank < FP_LEVELS - 1) ? rank : FP_LEVELS - 1;
+    }
+
+    for (task_t i = 1; i < MAX_TASKS; i++) {
+        if (tasks[i].tid != TID_NULL && (tasks[i].state == READY || tasks[i].state == RUNNING)) {
+            readyRemove(i);
+            readyInsert(i);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Refile a ready task whose key changed through inheritance or donation
+ *
+ * The key decides the task's fixed-priority level, and whether a
+ * background task is scheduled as real-time.
+ * 
+ * @retval None
+ */
+void keyChanged(task_t tid) {
+    if (tid != TID_NULL && (tasks[tid].state == READY || tasks[tid].state == RUNNING)) {
+        readyRemove(tid);
+        readyInsert(tid);
+    }
+}
+
+/**
+ * @brief Move a task to a new state, keeping the ready structures in step
+ * 
+ * @retval None
+ */
+static void setState(task_t tid, U8 state) {
+    U8 was_ready = tasks[tid].state == READY || tasks[tid].state == RUNNING;
+    U8 is_ready = state == READY || state == RUNNING;
+    if (tid != TID_NULL && was_ready && !is_ready) {
+        readyRemove(tid);
+    } else if (tid != TID_NULL && !was_ready && is_ready) {
+        readyInsert(tid);
+    }
+    tasks[tid].state = state;
+}
+
+#if ADMISSION_CONTROL
+/**
+ * @brief Convert DWT cycles to ms at the current core clock, rounding up
+ * 
+ * @retval Whole ms the cycles take
+ */
+static U32 cyclesToMs(U32 cycles) {
+    U32 per_ms = SystemCoreClock / 1000;
+    return (U32)(((unsigned long long)cycles + per_ms - 1) / per_ms);
+}
+
+/**
+ * @brief Worst-case execution time admission control counts for a task
+ *
+ * The TCB declares wcet_ms in ms, but an execution budget from setBudget()
+ * is in cycles. A task may use up to whichever allows more, so that is
+ * what is counted.
+ * 
+ * @retval wcet in ms, 0 if neither is set
+ */
+static U32 admittedWcet(task_t tid, U32 budget_cycles) {
+    U32 budget = cyclesToMs(budget_cycles);
+    return (budget > tasks[tid].wcet_ms) ? budget : tasks[tid].wcet_ms;
+}
+
+/**
+ * @brief Check that EDF can still meet every deadline with one task changed or added
+ *
+ * All parameters and times are in ms. Each task contributes its wcet (C)
+ * as given by admittedWcet(), period (T) and current deadline (D); a
+ * reserved task contributes its budget over its period. Tasks with no
+ * wcet aren't counted. The candidate parameters
+ * replace those of task skip, or are added as a new task if skip is
+ * TID_NULL. The set must have utilization at most 1 and, if any D < T,
+ * pass the processor-demand test: at every absolute deadline L up to
+ * the busy-period bound (capped at ADMISSION_HORIZON), the work due by L
+ * must fit in L.
+ * 
+ * @retval 1 if the resulting task set is schedulable, 0 otherwise
+ */
+static int admissible(task_t skip, U32 wcet, U32 period, U32 deadline) {
+    U32 c[MAX_TASKS], t[MAX_TASKS], d[MAX_TASKS];
+    int n = 0;
+    for (task_t i = 0; i < MAX_TASKS; i++) {
+        if (i == skip) {
+            // Candidate parameters, for a new task or the one being changed
+            c[n] = wcet;
+            d[n] = deadline;
+            t[n] = (period != 0) ? period : deadline;
+        } else if (i == TID_NULL || tasks[i].tid == TID_NULL || tasks[i].state == DORMANT || tasks[i].state == ZOMBIE
+                   || sched_class[i] == SCHED_BACKGROUND) {
+            continue;
+        } else if (reservations[i].budget != 0) {
+            c[n] = reservations[i].budget;
+            d[n] = t[n] = reservations[i].period;
+        } else {
+            c[n] = admittedWcet(i, budgets[i].wcet);
+            d[n] = tasks[i].deadline;
+            t[n] = (tasks[i].period != 0) ? tasks[i].period : tasks[i].deadline;
+        }
+        if (c[n] == 0) {
+            continue;
+        }
+        if (c[n] > d[n] || c[n] > t[n]) {
+            return 0;
+        }
+        n++;
+    }
+
+    // Utilization in units of 2^-32, and the busy-period bound terms in 2^-16
+    unsigned long long util = 0;
+    unsigned long long slack = 0;
+    U32 longest = 0;
+    int constrained = 0;
+    for (int i = 0; i < n; i++) {
+        util += ((unsigned long long)c[i] << 32) / t[i];
+        if (d[i] < t[i]) {
+            constrained = 1;
+            slack += (((unsigned long long)(t[i] - d[i]) * c[i] << 16) + t[i] - 1) / t[i];
+        }
+        if (d[i] > longest) {
+            longest = d[i];
+        }
+    }
+    if (util > (1ULL << 32)) {
+        return 0;
+    }
+    if (!constrained) {
+        return 1;
+    }
+
+    unsigned long long idle = (1ULL << 16) - ((util + 0xFFFF) >> 16);
+    unsigned long long bound = (idle != 0) ? (slack + idle - 1) / idle : ADMISSION_HORIZON;
+    if (bound < longest) {
+        bound = longest;
+    }
+    if (bound > ADMISSION_HORIZON) {
+        bound = ADMISSION_HORIZON;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (unsigned long long at = d[i]; at <= bound; at += t[i]) {
+            unsigned long long demand = 0;
+            for (int j = 0; j < n; j++) {
+                if (at >= d[j]) {
+                    demand += ((at - d[j]) / t[j] + 1) * c[j];
+                }
+            }
+            if (demand > at) {
+                return 0;
+            }
+        }
+    }
+    return 1;
 }
+#endif
 
 /**
  * @brief Register task with kernel
@@ -62,15 +430,36 @@ int createTask(TCB *task) {
     if (num_tasks == MAX_TASKS || task->stack_size < STACK_SIZE) {
         return RTX_ERR;
     }
+    // wcet_ms and period are only read by builds that use them, so other
+    // creators needn't fill them in. 0/0 declares nothing: no admission
+    // request, and ranked by deadline under SCHED_FIXED_PRIORITY
+#if ADMISSION_CONTROL || SCHED_FIXED_PRIORITY
+    U32 wcet_ms = task->wcet_ms;
+    U32 period = task->period;
+#else
+    U32 wcet_ms = 0;
+    U32 period = 0;
+#endif
+    if (wcet_ms > ((period != 0) ? period : DEFAULT_DEADLINE)) {
+        return RTX_ERR;
+    }
+#if ADMISSION_CONTROL
+    if ((wcet_ms != 0 || period != 0) && !admissible(TID_NULL, wcet_ms, period, DEFAULT_DEADLINE)) {
+        return RTX_ERR;
+    }
+#endif
 
     // Find open slot for TCB in kernel array
     task_t tid = TID_NULL;
     for (int i = 1; i < MAX_TASKS; i++) {
         if (tasks[i].tid == TID_NULL || tasks[i].state == DORMANT) {
-            void *stack_high = mem_alloc(task->stack_size);
-            if (stack_high != NULL) {
+            void *stack_low = mem_alloc(task->stack_size);
+            if (stack_low != NULL) {
                 tid = i;
-                task->stack_high = (U32)stack_high;
+                // The stack belongs to the new task, and is freed when it is reaped
+                mem_transfer(stack_low, running_task, tid);
+                // Stacks grow down from the end of the allocation
+                task->stack_high = (U32)stack_low + task->stack_size;
                 break;
             }
         }
@@ -85,23 +474,38 @@ int createTask(TCB *task) {
     task->tid = tid;
     task->state = READY;
     task->deadline = task->time_left = DEFAULT_DEADLINE;
+    task->wcet_ms = wcet_ms;
+    task->period = period;
     copy_TCB(task, &tasks[tid]);
+    ktasks[tid].inherit_left = 0;
+    lent_left[tid] = 0;
+    ktasks[tid].donated_left = 0;
+    ktasks[tid].wait_next = NULL;
+    ktasks[tid].wait_queue = NULL;
+    joiners[tid].head = NULL;
+    detached[tid] = 0;
+    task_group[tid] = GROUP_NONE;
+    reservations[tid].budget = 0;
+    sched_class[tid] = SCHED_REALTIME;
+    budgets[tid].wcet = 0;
+    budgets[tid].throttled = 0;
+    exit_status[tid] = 0;
 
-    // Setup new task's stack with dummy values
-    U32 *tmp_stack;
-    tmp_stack = (U32 *)tasks[tid].stack_high;
-    *(--tmp_stack) = 1 << 24;
-    *(--tmp_stack) = (U32)tasks[tid].ptask;
-    for (int i = 0; i < 14; i++) {
-        *(--tmp_stack) = 0xA;
+    // Paint the stack so stackUsage() can find how deep it ever got
+    for (U32 *word = (U32 *)(tasks[tid].stack_high - tasks[tid].stack_size); word < (U32 *)tasks[tid].stack_high; word++) {
+        *word = STACK_PAINT;
     }
 
-    tasks[tid].stackptr = (U32)tmp_stack;
+    // Setup new task's stack with dummy values
+    tasks[tid].stackptr = initStackFrame(tasks[tid].stack_high, tasks[tid].ptask);
     num_tasks++;
+#if SCHED_FIXED_PRIORITY
+    // Ranking files the now fully set up task in the ready bitmap with the rest
+    priorities[tid] = FP_AUTO;
+    rankPriorities();
+#endif
 
-    // May cause issues if kernel hasn't been started?
-    if (task->time_left < tasks[running_task].time_left)
-        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    preemptIfEarlier(tid);
     return RTX_OK;
 }
 
@@ -120,6 +524,7 @@ int startKernel(void) {
     tasks[running_task].state = RUNNING;
     stackptr = tasks[running_task].stack_high;
     __set_PSP(stackptr);
+    kernel_started = 1;
     scheduler();
 
     // Enable PendSV
@@ -129,21 +534,96 @@ int startKernel(void) {
 }
 
 /**
- * @brief Select next task available to run
+ * @brief Select next task available to run, or the null task if none are
+ *
+ * Real-time tasks come first. Under SCHED_FIXED_PRIORITY the highest ready
+ * level and the lowest TID ready at it are each a single CLZ on the ready
+ * bitmap. Background tasks only run when no real-time task is ready.
  * 
  * @retval None
  */
 void scheduler(void) {
+#if SCHED_FIXED_PRIORITY
+    selected_task = TID_NULL;
+    if (ready_levels != 0) {
+        selected_task = __CLZ(level_tasks[__CLZ(ready_levels)]);
+    }
+#else
     U32 shortest_deadline = UINT32_MAX;
+    selected_task = TID_NULL;
     for (int i = 0; i < MAX_TASKS; i++) {
-        // Select a non-null, non-terminated task with shortest deadline
-        if (tasks[i].tid != TID_NULL && (tasks[i].state == READY || tasks[i].state == RUNNING)) {
-            if ((tasks[i].time_left < shortest_deadline) || (tasks[i].time_left == shortest_deadline && i < selected_task)) {
+        // Select a non-null, non-terminated real-time task with shortest deadline
+        if (tasks[i].tid != TID_NULL && (tasks[i].state == READY || tasks[i].state == RUNNING) && !inBackground(i)) {
+            if ((taskKey(i) < shortest_deadline) || (taskKey(i) == shortest_deadline && i < selected_task)) {
                 selected_task = i;
-                shortest_deadline = tasks[i].time_left;
+                shortest_deadline = taskKey(i);
             }
         }
     }
+#endif
+    if (selected_task == TID_NULL && bg_ready != 0) {
+        selected_task = backgroundPick();
+    }
+}
+
+/**
+ * @brief Hold a task off until its next period, or let its overrun handler decide
+ *
+ * The handler runs in interrupt context. If it returns RTX_OK the task
+ * carries on with a fresh budget for this period.
+ * 
+ * @retval None
+ */
+static void budgetOverrun(task_t tid) {
+    execBudget *b = &budgets[tid];
+    if (b->on_overrun != NULL && b->on_overrun(tid) == RTX_OK) {
+        b->used = 0;
+        return;
+    }
+
+    b->throttled = 1;
+    if (tasks[tid].state == RUNNING || tasks[tid].state == READY) {
+        setState(tid, SLEEPING);
+    }
+    scheduler();
+    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief Charge the running task for the cycles since it was last charged
+ * 
+ * @retval None
+ */
+static void chargeRunning(void) {
+    U32 now = DWT->CYCCNT;
+    U32 elapsed = now - charged_at;
+    charged_at = now;
+
+    execBudget *b = &budgets[running_task];
+    if (running_task == TID_NULL || b->wcet == 0 || b->throttled) {
+        return;
+    }
+    b->used += elapsed;
+    if (b->used > b->wcet) {
+        budgetOverrun(running_task);
+    }
+}
+
+/**
+ * @brief Free the slot and stack of an exited task
+ *
+ * Must not be called while the task's stack is still in use.
+ * 
+ * @retval None
+ */
+static void reapTask(task_t tid) {
+    mem_dealloc_owned((void *)(tasks[tid].stack_high - tasks[tid].stack_size), tid);
+    setState(tid, DORMANT);
+    tasks[tid].tid = TID_NULL;
+    num_tasks--;
+#if SCHED_FIXED_PRIORITY
+    rankPriorities();
+#endif
 }
 
 /**
@@ -152,16 +632,28 @@ void scheduler(void) {
  * @retval None
  */
 void change_task(void) {
+    chargeRunning();
+
     // Update stack pointers
     stackptr = __get_PSP();
     tasks[running_task].stackptr = stackptr;
+
+    // The null task keeps no state, restart it from the top every time
+    if (selected_task == TID_NULL) {
+        tasks[TID_NULL].stackptr = initStackFrame(tasks[TID_NULL].stack_high, tasks[TID_NULL].ptask);
+    }
+
     stackptr = tasks[selected_task].stackptr;
     __set_PSP(stackptr);
 
     // Update states
-    if (tasks[running_task].state != DORMANT) {
+    if (tasks[running_task].state == RUNNING) {
         tasks[running_task].state = READY;
     }
+    // A task that exited with nobody left to join it is off its stack now
+    if (tasks[running_task].state == ZOMBIE && detached[running_task]) {
+        reapTask(running_task);
+    }
     tasks[selected_task].state = RUNNING;
     running_task = selected_task;
 }
@@ -182,6 +674,28 @@ int taskInfo(task_t tid, TCB* task_copy) {
     return RTX_OK;
 }
 
+/**
+ * @brief Measure the most stack a task has ever used
+ *
+ * Counts the painted words left untouched at the bottom of the stack, so
+ * the result is a high-water mark, not the current depth.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is not a task
+ */
+int stackUsage(task_t tid, U32 *used) {
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL || used == NULL) {
+        return RTX_ERR;
+    }
+
+    U32 *word = (U32 *)(tasks[tid].stack_high - tasks[tid].stack_size);
+    U32 *high = (U32 *)tasks[tid].stack_high;
+    while (word < high && *word == STACK_PAINT) {
+        word++;
+    }
+    *used = (U32)high - (U32)word;
+    return RTX_OK;
+}
+
 /**
  * @brief Get the TID of the currently running task
  * 
@@ -195,14 +709,34 @@ task_t getTID(void) {
     return tasks[running_task].tid;
 }
 
+/**
+ * @brief Start a task's next slot after it gives up the CPU
+ *
+ * Resets its deadline and budget, except for reserved tasks which keep
+ * their server deadline, ends a background timeslice and drops any key it
+ * was lent.
+ * 
+ * @retval None
+ */
+static void giveUp(task_t tid) {
+    if (inBackground(tid)) {
+        bg_slice = 0;
+    }
+    if (reservations[tid].budget == 0) {
+        tasks[tid].time_left = tasks[tid].deadline;
+        budgets[tid].used = 0;
+    }
+    lent_left[tid] = 0;
+    keyChanged(tid);
+}
+
 /**
  * @brief Save current task's context and switch to next available task
  * 
  * @retval None
  */
 void yield(void) {
-    // Reset deadline
-    tasks[running_task].time_left = tasks[running_task].deadline;
+    giveUp(running_task);
     // Select next task
     scheduler();
     // Enable PendSV
@@ -210,49 +744,777 @@ void yield(void) {
 }
 
 /**
- * @brief Exit currently running task
+ * @brief Give the rest of the running task's slot to a ready task and switch to it
+ *
+ * The target runs on the caller's own key, if that is more urgent than its
+ * own, until it yields or blocks, or under EDF until the lent time runs
+ * out. The caller then gives up the CPU as in yield(). If the target's key
+ * is then not later than the caller's was, nothing ready can be more
+ * urgent and the switch skips the selection pass; otherwise the target
+ * only runs next if scheduler() picks it.
  * 
- * @retval RTX_ERR on failure
+ * @retval RTX_OK on success, RTX_ERR if tid is not a ready task
  */
-int taskExit(void) {
-    // If the kernel hasn’t been initialized or no user‐task is running
-    if(!kernel_init_done || running_task == TID_NULL) {
+int yieldTo(task_t tid) {
+    if (!kernel_started || running_task == TID_NULL || tid == TID_NULL || tid >= MAX_TASKS
+        || tasks[tid].tid == TID_NULL || tasks[tid].state != READY) {
         return RTX_ERR;
     }
 
-    // Set running task to DORMANT and free the TID
-    tasks[running_task].state = DORMANT;
-    tasks[running_task].tid = TID_NULL; 
-    num_tasks--;
+    U32 minimum = taskKey(running_task);
+    U8 background = inBackground(running_task);
+    if (!background) {
+        lent_left[tid] = ownKey(running_task);
+        keyChanged(tid);
+    }
+    giveUp(running_task);
+    if (background && inBackground(tid)) {
+        // Hand over the background timeslice instead
+        bg_cursor = tid;
+        bg_slice = RR_TIMESLICE;
+    }
 
-    // Trigger PendSV to switch into the next task
-    scheduler();
-    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    handoffTask(tid, minimum);
     return RTX_OK;
 }
 
 /**
- * @brief Set deadline for any task
+ * @brief Reap a group and release its waiters once every member has exited
  *
- * @retval RTX_OK if deadline is strictly positive and task TID is ready, RTX_ERR otherwise
+ * The running task may be the last member out, in which case it is only
+ * marked for reaping once it is off its stack.
+ * 
+ * @retval None
  */
-int setDeadline(int deadline, task_t TID) {
+static void groupRelease(taskGroup *group) {
+    for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+        if (group->members & (1U << tid)) {
+            task_group[tid] = GROUP_NONE;
+            if (tid == running_task) {
+                detached[tid] = 1;
+            } else {
+                reapTask(tid);
+            }
+        }
+    }
+    group->members = 0;
+    while (wakeFirst(&group->waiters, RTX_OK) != TID_NULL) {
+    }
+}
 
-    __disable_irq(); // Disable interrupts
+/**
+ * @brief Release a group if all of its members have exited and someone waits on it
+ * 
+ * @retval None
+ */
+static void groupCheck(taskGroup *group) {
+    for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+        if ((group->members & (1U << tid)) && tasks[tid].state != ZOMBIE) {
+            return;
+        }
+    }
+    if (group->waiters.head != NULL) {
+        groupRelease(group);
+    }
+}
 
-    if (deadline <= 0 || TID >= MAX_TASKS || TID == running_task || tasks[TID].state != READY) {
-        __enable_irq();
+/**
+ * @brief Exit the running task, handing status to any tasks joining it
+ *
+ * Tasks already blocked in taskJoin() get the status and the slot is
+ * reaped as soon as the task is switched out. Otherwise a joinable task
+ * stays a ZOMBIE holding its slot and stack until it is joined or
+ * detached, and any other task outside a group is reaped straight away.
+ * 
+ * @retval RTX_ERR on failure
+ */
+static int exitTask(int status, U8 joinable) {
+    // If the kernel hasn't been initialized or no user-task is running
+    if(!kernel_init_done || running_task == TID_NULL) {
         return RTX_ERR;
     }
 
-    tasks[TID].deadline = tasks[TID].time_left = deadline;
+    setState(running_task, ZOMBIE);
+    exit_status[running_task] = status;
 
-    // if task TID's deadline is less than currently running task, trigger context switch
-    if (tasks[TID].deadline < tasks[running_task].deadline) {
-        scheduler();
-        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    TCB *joiner;
+    while ((joiner = joiners[running_task].head) != NULL) {
+        // The status pointer is still in r1 of the joiner's blocked SVC
+        int *out = (int *)ktasks[joiner->tid].wait_frame[1];
+        if (out != NULL) {
+            *out = status;
+        }
+        wakeTask(joiner->tid, RTX_OK);
+        detached[running_task] = 1;
+    }
+    if (task_group[running_task] != GROUP_NONE) {
+        groupCheck(&groups[task_group[running_task]]);
+    } else if (!joinable) {
+        detached[running_task] = 1;
     }
 
-    __enable_irq();
+    // Trigger PendSV to switch into the next task, which reaps us if detached
+    scheduler();
+    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
     return RTX_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Exit currently running task
+ *
+ * Its slot and stack are recycled as soon as it is switched out, unless
+ * a group holds it. Tasks already joining it see status 0.
+ * 
+ * @retval RTX_ERR on failure
+ */
+int taskExit(void) {
+    return exitTask(0, 0);
+}
+
+/**
+ * @brief Exit currently running task with a status for osTaskJoin()
+ *
+ * Unless someone is already joining it, the task stays a ZOMBIE holding
+ * its slot and stack until it is joined or detached.
+ * 
+ * @retval RTX_ERR on failure
+ */
+int taskExitCode(int status) {
+    return exitTask(status, 1);
+}
+
+/**
+ * @brief Wait for a task to exit, blocking for up to timeout ms, and reap it
+ *
+ * Any number of tasks may join the same task; all of them get its status.
+ * 
+ * @retval RTX_OK once joined, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int taskJoin(task_t tid, int *status, U32 timeout) {
+    if (running_task == TID_NULL || tid == TID_NULL || tid >= MAX_TASKS || tid == running_task
+        || tasks[tid].tid == TID_NULL || detached[tid] || task_group[tid] != GROUP_NONE) {
+        return RTX_ERR;
+    }
+
+    if (tasks[tid].state == ZOMBIE) {
+        if (status != NULL) {
+            *status = exit_status[tid];
+        }
+        reapTask(tid);
+        return RTX_OK;
+    }
+    return blockTask(&joiners[tid], timeout);
+}
+
+/**
+ * @brief Let a task's slot and stack be recycled as soon as it exits, without a join
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is invalid, already detached, being joined or in a group
+ */
+int taskDetach(task_t tid) {
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL || detached[tid]
+        || joiners[tid].head != NULL || task_group[tid] != GROUP_NONE) {
+        return RTX_ERR;
+    }
+
+    if (tasks[tid].state == ZOMBIE) {
+        reapTask(tid);
+    } else {
+        detached[tid] = 1;
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Run a task as a Constant Bandwidth Server with budget Q per period P
+ *
+ * A reserved task is scheduled by EDF on its server deadline instead of
+ * its own. Each ms it runs uses up budget; when the budget runs out it is
+ * recharged and the server deadline pushed back by P, so a task that
+ * overruns only delays itself and never takes more than Q/P of the CPU
+ * from the others. A budget of 0 ends the reservation.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is not a task or budget exceeds period
+ */
+int setReservation(task_t tid, U32 budget, U32 period) {
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL || budget > period) {
+        return RTX_ERR;
+    }
+#if ADMISSION_CONTROL
+    if (budget != 0 ? !admissible(tid, budget, period, period)
+                    : !admissible(tid, tasks[tid].wcet_ms, tasks[tid].period, tasks[tid].deadline)) {
+        return RTX_ERR;
+    }
+#endif
+
+    reservation *r = &reservations[tid];
+    r->budget = budget;
+    budgets[tid].wcet = 0;
+    if (budgets[tid].throttled) {
+        budgets[tid].throttled = 0;
+        if (tasks[tid].state == SLEEPING) {
+            setState(tid, READY);
+        }
+    }
+    if (budget == 0) {
+        tasks[tid].time_left = tasks[tid].deadline;
+    } else {
+        r->period = period;
+        r->left = budget;
+        r->due = HAL_GetTick() + period;
+        tasks[tid].time_left = period;
+    }
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Limit how many CPU cycles a task may use per deadline period
+ *
+ * Cycles are counted with the DWT cycle counter at every context switch
+ * and every tick. A task that uses more than wcet in one period is held
+ * off until its next period starts, unless on_overrun (which may be NULL)
+ * returns RTX_OK. A period ends when the task yields or its deadline
+ * comes around. wcet 0 removes the limit. Reserved tasks are already
+ * limited by their reservation and can't have one. Unlike the wcet_ms
+ * declared in the TCB, wcet here is in CPU cycles; under
+ * ADMISSION_CONTROL the budget is converted to ms and checked like one.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is not an unreserved task or the budget is not admissible
+ */
+int setBudget(task_t tid, U32 wcet, int (*on_overrun)(task_t tid)) {
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL || reservations[tid].budget != 0) {
+        return RTX_ERR;
+    }
+#if ADMISSION_CONTROL
+    if (!admissible(tid, admittedWcet(tid, wcet), tasks[tid].period, tasks[tid].deadline)) {
+        return RTX_ERR;
+    }
+#endif
+
+    budgets[tid].wcet = wcet;
+    budgets[tid].used = 0;
+    budgets[tid].on_overrun = on_overrun;
+    if (budgets[tid].throttled) {
+        budgets[tid].throttled = 0;
+        if (tasks[tid].state == SLEEPING) {
+            setState(tid, READY);
+        }
+        reschedule();
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief Pin a task to a fixed priority level, or return it to its rate-monotonic rank
+ *
+ * Only available under SCHED_FIXED_PRIORITY. Level 0 is the highest;
+ * FP_AUTO ranks the task by its period again.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is not a task or the level is out of range
+ */
+int setPriority(task_t tid, U32 priority) {
+#if SCHED_FIXED_PRIORITY
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL
+        || (priority >= FP_LEVELS && priority != FP_AUTO)) {
+        return RTX_ERR;
+    }
+
+    priorities[tid] = priority;
+    rankPriorities();
+    reschedule();
+    return RTX_OK;
+#else
+    (void)tid;
+    (void)priority;
+    return RTX_ERR;
+#endif
+}
+
+/**
+ * @brief Move a task between the real-time and background scheduling classes
+ *
+ * Background tasks need no deadline: they share the CPU round-robin, each
+ * holding it for up to RR_TIMESLICE ms, whenever no real-time task is
+ * ready.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if tid is not a task or the class is unknown
+ */
+int setClass(task_t tid, U32 cls) {
+    if (tid == TID_NULL || tid >= MAX_TASKS || tasks[tid].tid == TID_NULL
+        || (cls != SCHED_REALTIME && cls != SCHED_BACKGROUND)) {
+        return RTX_ERR;
+    }
+
+    U8 ready = tasks[tid].state == READY || tasks[tid].state == RUNNING;
+    if (ready) {
+        readyRemove(tid);
+    }
+    sched_class[tid] = cls;
+    if (ready) {
+        readyInsert(tid);
+    }
+#if SCHED_FIXED_PRIORITY
+    rankPriorities();
+#endif
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Advance every task's time to deadline by one tick
+ *
+ * Called from SysTick. An unreserved task that reaches its deadline starts
+ * over with a full deadline and execution budget. A reserved task tracks its server deadline,
+ * and the running one is charged the tick against its budget.
+ * 
+ * @retval None
+ */
+void deadlineTick(void) {
+    chargeRunning();
+
+    // The next selection passes the CPU on once the timeslice runs out
+    if (running_task != TID_NULL && running_task == bg_cursor && inBackground(running_task) && bg_slice > 0) {
+        bg_slice--;
+    }
+
+    U32 now = HAL_GetTick();
+    for (int i = 1; i < MAX_TASKS; i++) {
+#if !SCHED_FIXED_PRIORITY
+        U8 was_background = inBackground(i);
+        // An inherited deadline draws nearer in step with the blocked waiter
+        // it came from, but stays inherited
+        if (ktasks[i].inherit_left > 1) {
+            ktasks[i].inherit_left--;
+        }
+        // Lent time runs out like the lender's own would have
+        if (lent_left[i] != 0 && --lent_left[i] == 0) {
+            SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+        }
+        if (inBackground(i) != was_background) {
+            keyChanged(i);
+        }
+#endif
+        reservation *r = &reservations[i];
+        if (r->budget != 0 && tasks[i].tid != TID_NULL) {
+            if (tasks[i].state == RUNNING && --r->left == 0) {
+                // Budget exhausted, postpone the deadline and recharge
+                r->left = r->budget;
+                r->due += r->period;
+                SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+            }
+            int until_due = (int)(r->due - now);
+            if (until_due <= 0 && (tasks[i].state == RUNNING || tasks[i].state == READY)) {
+                // Deadline reached with budget to spare, start a new period
+                r->left = r->budget;
+                r->due = now + r->period;
+                until_due = r->period;
+            }
+            tasks[i].time_left = (until_due > 0) ? (U32)until_due : 1;
+            continue;
+        }
+
+        // Time ticks down for all ready/running tasks, and throttled ones
+        if (tasks[i].state == RUNNING || tasks[i].state == READY || (tasks[i].state == SLEEPING && budgets[i].throttled)) {
+            tasks[i].time_left--;
+            if (tasks[i].time_left == 0) {
+                tasks[i].time_left = tasks[i].deadline;
+                budgets[i].used = 0;
+                if (budgets[i].throttled) {
+                    budgets[i].throttled = 0;
+                    setState(i, READY);
+                }
+                SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+            }
+        } else if (tasks[i].state == BLOCKED && tasks[i].time_left > 1) {
+            // Blocked tasks' deadlines draw nearer too, so wait queues stay
+            // in deadline order whenever their tasks blocked. One still
+            // blocked when it comes due stays due until it runs again.
+            tasks[i].time_left--;
+        }
+    }
+}
+
+/**
+ * @brief Give a task a new deadline and time left, keeping its ranking current
+ *
+ * Refiles the task wherever its key decides its place: the fixed-priority
+ * levels, the background class and, if it is blocked, its wait queue.
+ * Callers decide whether the change should preempt the running task.
+ * 
+ * @retval None
+ */
+void retimeTask(task_t tid, U32 deadline, U32 time_left) {
+    tasks[tid].deadline = deadline;
+    tasks[tid].time_left = time_left;
+#if SCHED_FIXED_PRIORITY
+    rankPriorities();
+#else
+    keyChanged(tid);
+#endif
+    requeueTask(tid);
+}
+
+/**
+ * @brief Set deadline for any task
+ *
+ * @retval RTX_OK if deadline is strictly positive and task TID is ready, RTX_ERR otherwise
+ */
+int setDeadline(int deadline, task_t TID) {
+
+    __disable_irq(); // Disable interrupts
+
+    if (deadline <= 0 || TID >= MAX_TASKS || TID == running_task || tasks[TID].state != READY) {
+        __enable_irq();
+        return RTX_ERR;
+    }
+#if ADMISSION_CONTROL
+    if (reservations[TID].budget == 0
+        && !admissible(TID, admittedWcet(TID, budgets[TID].wcet), tasks[TID].period, deadline)) {
+        __enable_irq();
+        return RTX_ERR;
+    }
+#endif
+
+    retimeTask(TID, deadline, deadline);
+
+    // if task TID's deadline is less than currently running task, trigger context switch
+    if (tasks[TID].deadline < tasks[running_task].deadline) {
+        scheduler();
+        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    }
+
+    __enable_irq();
+    return RTX_OK;
+}
+
+/**
+ * @brief Insert a task behind every waiter with an earlier or equal deadline
+ * 
+ * @retval None
+ */
+static void enqueueTask(waitQueue *queue, task_t tid) {
+    TCB **link = &queue->head;
+    while (*link != NULL && taskKey((*link)->tid) <= taskKey(tid)) {
+        link = &ktasks[(*link)->tid].wait_next;
+    }
+    ktasks[tid].wait_next = *link;
+    *link = &tasks[tid];
+    ktasks[tid].wait_queue = queue;
+}
+
+/**
+ * @brief Unlink a task from the wait queue it is on, if any
+ * 
+ * @retval None
+ */
+static void dequeueTask(task_t tid) {
+    kernelTCB *k = &ktasks[tid];
+    if (k->wait_queue != NULL) {
+        TCB **link = &k->wait_queue->head;
+        while (*link != NULL && *link != &tasks[tid]) {
+            link = &ktasks[(*link)->tid].wait_next;
+        }
+        if (*link == &tasks[tid]) {
+            *link = k->wait_next;
+        }
+    }
+    k->wait_next = NULL;
+    k->wait_queue = NULL;
+}
+
+/**
+ * @brief Block the running task on a wait queue until woken or timed out
+ *
+ * Must be called from an SVC. The task is inserted behind every waiter with
+ * an earlier or equal deadline, so wakeFirst() always picks the most urgent
+ * one and equal deadlines are served FIFO. The return value is what the
+ * blocked call will see if it times out; wakeTask() overwrites it in the
+ * task's stacked r0.
+ *
+ * @retval RTX_TIMEOUT if blocked or timeout is 0, RTX_ERR if the caller can't block
+ */
+int blockTask(waitQueue *queue, U32 timeout) {
+    if (!kernel_started || running_task == TID_NULL) {
+        return RTX_ERR;
+    }
+    if (timeout == 0) {
+        return RTX_TIMEOUT;
+    }
+
+    parkTask(queue, timeout);
+    scheduler();
+    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    return RTX_TIMEOUT;
+}
+
+/**
+ * @brief Block the running task on a wait queue without a selection pass
+ *
+ * Like blockTask(), but the caller then decides what runs next, normally
+ * with handoffTask().
+ *
+ * @retval RTX_TIMEOUT if blocked, RTX_ERR if the caller can't block
+ */
+int parkTask(waitQueue *queue, U32 timeout) {
+    if (!kernel_started || running_task == TID_NULL || timeout == 0) {
+        return RTX_ERR;
+    }
+
+    lent_left[running_task] = 0;
+    enqueueTask(queue, running_task);
+    ktasks[running_task].wait_timeout = timeout;
+    ktasks[running_task].wait_frame = (U32 *)__get_PSP();
+    setState(running_task, BLOCKED);
+    return RTX_TIMEOUT;
+}
+
+/**
+ * @brief Switch straight to a ready task if nothing ready can be more urgent
+ *
+ * minimum is the key the running task had on entry to the kernel. No other
+ * ready task can beat it, so a task whose key is not later than it is
+ * exactly what scheduler() would pick and the selection pass is skipped.
+ * Otherwise, and for background tasks, scheduler() decides, with the task
+ * giving up the CPU losing ties to tid.
+ *
+ * @retval None
+ */
+void handoffTask(task_t tid, U32 minimum) {
+    if (tasks[tid].state == READY && !inBackground(tid) && taskKey(tid) <= minimum) {
+        selected_task = tid;
+    } else {
+        scheduler();
+        if (selected_task == running_task && tasks[tid].state == READY && taskKey(tid) <= taskKey(running_task)) {
+            selected_task = tid;
+        }
+    }
+    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief Apply the CBS wake-up rule to a reserved task becoming ready
+ *
+ * The current server deadline is kept only if the budget left can be
+ * spent before it without exceeding the reserved bandwidth Q/P; otherwise
+ * the task starts a fresh period with a full budget.
+ * 
+ * @retval None
+ */
+static void reservationWake(task_t tid) {
+    reservation *r = &reservations[tid];
+    U32 now = HAL_GetTick();
+    int until_due = (int)(r->due - now);
+    if (until_due <= 0 || (unsigned long long)r->left * r->period >= (unsigned long long)until_due * r->budget) {
+        r->due = now + r->period;
+        r->left = r->budget;
+        until_due = r->period;
+    }
+    tasks[tid].time_left = until_due;
+}
+
+/**
+ * @brief Make a blocked task ready and set the return value of its blocking call
+ * 
+ * @retval None
+ */
+void wakeTask(task_t tid, int ret) {
+    if (tasks[tid].state != BLOCKED) {
+        return;
+    }
+
+    dequeueTask(tid);
+    ktasks[tid].wait_frame[0] = ret;
+    // A task that overran just before blocking still sits out its period
+    setState(tid, budgets[tid].throttled ? SLEEPING : READY);
+    if (reservations[tid].budget != 0) {
+        reservationWake(tid);
+    }
+}
+
+/**
+ * @brief Wake the most urgent task on a wait queue
+ * 
+ * @retval TID of the woken task, TID_NULL if the queue was empty
+ */
+task_t wakeFirst(waitQueue *queue, int ret) {
+    if (queue->head == NULL) {
+        return TID_NULL;
+    }
+    task_t tid = queue->head->tid;
+    wakeTask(tid, ret);
+    return tid;
+}
+
+/**
+ * @brief Move a blocked task to its place in its queue after its deadline changed
+ * 
+ * @retval None
+ */
+void requeueTask(task_t tid) {
+    waitQueue *queue = ktasks[tid].wait_queue;
+    if (tasks[tid].state != BLOCKED || queue == NULL) {
+        return;
+    }
+    dequeueTask(tid);
+    enqueueTask(queue, tid);
+}
+
+/**
+ * @brief Move a blocked task to another wait queue without waking it
+ * 
+ * @retval None
+ */
+void moveWaiter(task_t tid, waitQueue *queue, U32 timeout) {
+    if (tasks[tid].state != BLOCKED) {
+        return;
+    }
+    dequeueTask(tid);
+    enqueueTask(queue, tid);
+    ktasks[tid].wait_timeout = timeout;
+}
+
+/**
+ * @brief Trigger a context switch only if a task should preempt the running one
+ * 
+ * @retval None
+ */
+void preemptIfEarlier(task_t tid) {
+    if (!kernel_started) {
+        return;
+    }
+    if (taskKey(tid) < taskKey(running_task)) {
+        scheduler();
+        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+/**
+ * @brief Count down blocking-call timeouts, called once per SysTick
+ * 
+ * @retval None
+ */
+void timeoutTick(void) {
+    for (int i = 1; i < MAX_TASKS; i++) {
+        if (tasks[i].state == BLOCKED && ktasks[i].wait_timeout != OS_WAIT_FOREVER) {
+            if (--ktasks[i].wait_timeout == 0) {
+                waitQueue *queue = ktasks[i].wait_queue;
+                wakeTask(i, RTX_TIMEOUT);
+                waitAborted(queue);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Re-run selection and switch if the running task is no longer the earliest
+ * 
+ * @retval None
+ */
+void reschedule(void) {
+    if (!kernel_started) {
+        return;
+    }
+    scheduler();
+    if (selected_task != running_task) {
+        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+/**
+ * @brief Allocate an empty task group
+ * 
+ * @retval RTX_OK and the group ID on success, RTX_ERR if none are free
+ */
+int groupCreate(group_t *group) {
+    if (group == NULL) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_GROUPS; i++) {
+        if (!groups[i].in_use) {
+            groups[i].in_use = 1;
+            groups[i].members = 0;
+            groups[i].waiters.head = NULL;
+            *group = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Create a task as a member of a group
+ *
+ * Members are reaped by groupWait() or groupKill() and can't be joined or
+ * detached on their own.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int groupSpawn(group_t group, TCB *task) {
+    if (group >= MAX_GROUPS || !groups[group].in_use || task == NULL) {
+        return RTX_ERR;
+    }
+
+    if (createTask(task) != RTX_OK) {
+        return RTX_ERR;
+    }
+    groups[group].members |= 1U << task->tid;
+    task_group[task->tid] = group;
+    return RTX_OK;
+}
+
+/**
+ * @brief Wait for every member of a group to exit, blocking for up to timeout ms, and reap them
+ *
+ * The group is empty afterwards and can be spawned into again.
+ * 
+ * @retval RTX_OK once all have exited, RTX_TIMEOUT if it timed out, RTX_ERR on failure
+ */
+int groupWait(group_t group, U32 timeout) {
+    if (group >= MAX_GROUPS || !groups[group].in_use || running_task == TID_NULL
+        || task_group[running_task] == group) {
+        return RTX_ERR;
+    }
+
+    taskGroup *g = &groups[group];
+    for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+        if ((g->members & (1U << tid)) && tasks[tid].state != ZOMBIE) {
+            return blockTask(&g->waiters, timeout);
+        }
+    }
+    groupRelease(g);
+    return RTX_OK;
+}
+
+/**
+ * @brief Terminate every member of a group still running and reap them all
+ *
+ * Members blocked on a kernel object are pulled off its wait queue first.
+ * Anything else a member held, such as a locked mutex, stays held. Tasks
+ * blocked in groupWait() return RTX_OK.
+ * 
+ * @retval RTX_OK on success, RTX_ERR on failure
+ */
+int groupKill(group_t group) {
+    if (group >= MAX_GROUPS || !groups[group].in_use || running_task == TID_NULL
+        || task_group[running_task] == group) {
+        return RTX_ERR;
+    }
+
+    taskGroup *g = &groups[group];
+    for (task_t tid = 1; tid < MAX_TASKS; tid++) {
+        if ((g->members & (1U << tid)) && tasks[tid].state != ZOMBIE) {
+            waitQueue *queue = ktasks[tid].wait_queue;
+            if (queue != NULL) {
+                dequeueTask(tid);
+                waitAborted(queue);
+            }
+            setState(tid, ZOMBIE);
+            exit_status[tid] = RTX_ERR;
+        }
+    }
+    groupRelease(g);
+    reschedule();
+    return RTX_OK;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include "k_workq.h"
+#include "k_task.h"
+#include "stm32f401xe.h"
+#include "stm32f4xx_hal.h"
+
+extern TCB tasks[MAX_TASKS];
+extern kernelTCB ktasks[MAX_TASKS];
+extern task_t running_task;
+
+static workQueue workqs[MAX_WORKQUEUES];
+static U8 worker_queue[MAX_TASKS]; // work queue ID + 1 the task serves, 0 if not a worker
+
+/**
+ * @brief Body of every worker task: run jobs until the end of time
+ * 
+ * @retval None
+ */
+static void workerMain(void *args) {
+    workJob job;
+    while (1) {
+        if (osWorkqNext(&job) == RTX_OK) {
+            job.fn(job.arg);
+        }
+    }
+}
+
+/**
+ * @brief Allocate a work queue served by a pool of new worker tasks
+ *
+ * The workers are created immediately and park until jobs are submitted.
+ * 
+ * @retval RTX_OK and the queue ID on success, RTX_ERR on failure
+ */
+int workqCreate(workq_t *wq, U32 workers, U16 stack_size) {
+    if (wq == NULL || workers == 0) {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_WORKQUEUES; i++) {
+        if (!workqs[i].in_use) {
+            workqs[i].count = 0;
+            workqs[i].idle.head = NULL;
+
+            for (U32 n = 0; n < workers; n++) {
+                TCB worker;
+                worker.ptask = workerMain;
+                worker.wcet_ms = 0;
+                worker.period = 0;
+                worker.stack_size = stack_size;
+                if (createTask(&worker) != RTX_OK) {
+                    // Workers already created keep serving the queue
+                    break;
+                }
+                worker_queue[worker.tid] = i + 1;
+                if (n == 0) {
+                    workqs[i].in_use = 1;
+                }
+            }
+            if (!workqs[i].in_use) {
+                return RTX_ERR;
+            }
+            *wq = i;
+            return RTX_OK;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief Make a worker run a job under the job's deadline
+ *
+ * The worker's time left is what remains until the job is due, so a job
+ * that waited in the queue runs more urgently under EDF.
+ * 
+ * @retval None
+ */
+static void assignJob(task_t tid, const pendingJob *pending) {
+    int left = (int)(pending->due - HAL_GetTick());
+    retimeTask(tid, pending->job.deadline, (left > 0) ? (U32)left : 1);
+}
+
+/**
+ * @brief Remove the earliest due job from a queue
+ * 
+ * @retval None
+ */
+static void popJob(workQueue *q, pendingJob *out) {
+    *out = q->pending[0];
+    q->count--;
+    for (U32 i = 0; i < q->count; i++) {
+        q->pending[i] = q->pending[i + 1];
+    }
+}
+
+/**
+ * @brief Queue a batch of jobs in one call and hand them to idle workers
+ *
+ * The batch is taken whole or not at all. A job deadline of 0 means
+ * DEFAULT_DEADLINE.
+ * 
+ * @retval RTX_OK on success, RTX_ERR if the batch doesn't fit or a job is invalid
+ */
+int workqSubmit(workq_t wq, const workJob *jobs, U32 count) {
+    if (wq >= MAX_WORKQUEUES || !workqs[wq].in_use || jobs == NULL) {
+        return RTX_ERR;
+    }
+
+    workQueue *q = &workqs[wq];
+    if (count > WORKQ_DEPTH - q->count) {
+        return RTX_ERR;
+    }
+    for (U32 n = 0; n < count; n++) {
+        if (jobs[n].fn == NULL) {
+            return RTX_ERR;
+        }
+    }
+
+    U32 now = HAL_GetTick();
+    for (U32 n = 0; n < count; n++) {
+        pendingJob pending;
+        pending.job = jobs[n];
+        if (pending.job.deadline == 0) {
+            pending.job.deadline = DEFAULT_DEADLINE;
+        }
+        pending.due = now + pending.job.deadline;
+
+        U32 i = q->count;
+        while (i > 0 && (int)(q->pending[i - 1].due - pending.due) > 0) {
+            q->pending[i] = q->pending[i - 1];
+            i--;
+        }
+        q->pending[i] = pending;
+        q->count++;
+    }
+
+    while (q->count > 0 && q->idle.head != NULL) {
+        TCB *worker = q->idle.head;
+        pendingJob pending;
+        popJob(q, &pending);
+        *(workJob *)ktasks[worker->tid].wait_info = pending.job;
+        assignJob(worker->tid, &pending);
+        wakeTask(worker->tid, RTX_OK);
+    }
+    reschedule();
+    return RTX_OK;
+}
+
+/**
+ * @brief Fetch the next job for the calling worker, parking it until there is one
+ * 
+ * @retval RTX_OK with the job filled in, RTX_ERR if the caller is not a worker
+ */
+int workqNext(workJob *job) {
+    if (job == NULL || running_task == TID_NULL || worker_queue[running_task] == 0) {
+        return RTX_ERR;
+    }
+
+    workQueue *q = &workqs[worker_queue[running_task] - 1];
+    if (q->count == 0) {
+        // workqSubmit() fills in the job through wait_info when it wakes us
+        int ret = blockTask(&q->idle, OS_WAIT_FOREVER);
+        ktasks[running_task].wait_info = (U32)job;
+        return ret;
+    }
+
+    pendingJob pending;
+    popJob(q, &pending);
+    *job = pending.job;
+    assignJob(running_task, &pending);
+    reschedule();
+    return RTX_OK;
+}
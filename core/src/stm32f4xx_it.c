@@ -192,16 +192,10 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-  // Time ticks down for all ready/running tasks
-  for (int i = 1; i < MAX_TASKS; i++) {
-    if (tasks[i].state == RUNNING || tasks[i].state == READY) {
-      tasks[i].time_left--;
-      if (tasks[i].time_left == 0) {
-        tasks[i].time_left = tasks[i].deadline;
-        SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
-      }
-    }
-  }
+  // Advance deadlines and charge reservation budgets
+  deadlineTick();
+  // Wake tasks whose blocking calls have timed out
+  timeoutTick();
   // If there's a task with a deadline shorter than the current one, trigger a context-switch
   scheduler();
   if (selected_task != running_task)
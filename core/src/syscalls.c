@@ -32,6 +32,11 @@
 
 #include "k_task.h"
 #include "k_mem.h"
+#include "k_sync.h"
+#include "k_msg.h"
+#include "k_ring.h"
+#include "k_workq.h"
+#include "k_rtc.h"
 #include "stm32f401xe.h"
 
 /* Variables */
@@ -190,6 +195,72 @@ int _execve(char *name, char **argv, char **env)
  *          4: taskInfo
  *          5: getTID
  *          6: taskExit
+ *          7: mem_init
+ *          8: mem_alloc
+ *          9: mem_dealloc
+ *         10: mem_count_extfrag
+ *         11: mem_stats
+ *         12: setDeadline
+ *         14: mem_alloc_movable
+ *         15: mem_lock
+ *         16: mem_unlock
+ *         17: mem_dealloc_movable
+ *         18: mem_compact
+ *         19: semCreate
+ *         20: semWait
+ *         21: semPost
+ *         22: mutexCreate
+ *         23: mutexLock
+ *         24: mutexUnlock
+ *         25: futexWait
+ *         26: futexWake
+ *         27: mem_transfer
+ *         28: queueCreate
+ *         29: queueSend
+ *         30: queueSend (k_mem block)
+ *         31: queueReceive
+ *         32: ringWait
+ *         33: eventCreate
+ *         34: eventSet
+ *         35: eventClear
+ *         36: eventWait
+ *         37: ipcSend
+ *         38: ipcReceive
+ *         39: ipcReply
+ *         40: yieldTo
+ *         41: mem_alloc_shared
+ *         42: mem_dealloc_shared
+ *         43: topicCreate
+ *         44: subscribe
+ *         45: publish
+ *         46: topicReceive
+ *         47: condCreate
+ *         48: condWait
+ *         49: condSignal
+ *         50: condBroadcast
+ *         51: rwLockCreate
+ *         52: rwLockRead
+ *         53: rwLockWrite
+ *         54: rwLockUnlock
+ *         55: taskJoin
+ *         56: taskDetach
+ *         57: barrierCreate
+ *         58: barrierWait
+ *         59: groupCreate
+ *         60: groupSpawn
+ *         61: groupWait
+ *         62: groupKill
+ *         63: workqCreate
+ *         64: workqSubmit
+ *         65: workqNext
+ *         66: rtcCreate
+ *         67: rtcNext
+ *         68: stackUsage
+ *         69: setReservation
+ *         70: setBudget
+ *         71: setPriority
+ *         72: setClass
+ *         73: taskExitCode
  * @retval None
  */
 void SVC_Handler_Main(unsigned int *svc_args) {
@@ -270,14 +341,447 @@ void SVC_Handler_Main(unsigned int *svc_args) {
       svc_args[0] = ret;
       break;
     }
+    case 11: {
+      memStats *stats = (memStats *)svc_args[0];
+      ret = mem_stats(stats);
+      svc_args[0] = ret;
+      break;
+    }
     case 12: {
         int deadline = (int)svc_args[0];
         task_t TID = (task_t)svc_args[1];
-        ret = osSetDeadline(deadline, TID);
+        ret = setDeadline(deadline, TID);
         // retval to get popped back into r0
         svc_args[0] = ret;
         break;
     }
+    case 14: {
+      size_t size = (size_t)svc_args[0];
+      mem_handle_t *handle = (mem_handle_t *)svc_args[1];
+      ret = mem_alloc_movable(size, handle);
+      svc_args[0] = ret;
+      break;
+    }
+    case 15: {
+      mem_handle_t handle = (mem_handle_t)svc_args[0];
+      void *ptr = mem_lock(handle);
+      svc_args[0] = (unsigned int)ptr;
+      break;
+    }
+    case 16: {
+      mem_handle_t handle = (mem_handle_t)svc_args[0];
+      ret = mem_unlock(handle);
+      svc_args[0] = ret;
+      break;
+    }
+    case 17: {
+      mem_handle_t handle = (mem_handle_t)svc_args[0];
+      ret = mem_dealloc_movable(handle);
+      svc_args[0] = ret;
+      break;
+    }
+    case 18: {
+      ret = mem_compact();
+      svc_args[0] = ret;
+      break;
+    }
+    case 19: {
+      semaphore_t *sem = (semaphore_t *)svc_args[0];
+      U32 count = (U32)svc_args[1];
+      ret = semCreate(sem, count);
+      svc_args[0] = ret;
+      break;
+    }
+    case 20: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      semaphore_t sem = (semaphore_t)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = semWait(sem, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 21: {
+      semaphore_t sem = (semaphore_t)svc_args[0];
+      ret = semPost(sem);
+      svc_args[0] = ret;
+      break;
+    }
+    case 22: {
+      mutex_t *mutex = (mutex_t *)svc_args[0];
+      ret = mutexCreate(mutex);
+      svc_args[0] = ret;
+      break;
+    }
+    case 23: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      mutex_t mutex = (mutex_t)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = mutexLock(mutex, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 24: {
+      mutex_t mutex = (mutex_t)svc_args[0];
+      ret = mutexUnlock(mutex);
+      svc_args[0] = ret;
+      break;
+    }
+    case 25: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      volatile U32 *addr = (volatile U32 *)svc_args[0];
+      U32 expected = (U32)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = futexWait(addr, expected, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 26: {
+      volatile U32 *addr = (volatile U32 *)svc_args[0];
+      U32 count = (U32)svc_args[1];
+      ret = futexWake(addr, count);
+      svc_args[0] = ret;
+      break;
+    }
+    case 27: {
+      void *ptr = (void *)svc_args[0];
+      task_t tid = (task_t)svc_args[1];
+      ret = mem_transfer(ptr, running_task, tid);
+      svc_args[0] = ret;
+      break;
+    }
+    case 28: {
+      queue_t *queue = (queue_t *)svc_args[0];
+      U32 capacity = (U32)svc_args[1];
+      ret = queueCreate(queue, capacity);
+      svc_args[0] = ret;
+      break;
+    }
+    case 29:
+    case 30: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      queue_t queue = (queue_t)svc_args[0];
+      U32 msg = (U32)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = queueSend(queue, msg, timeout, svc_number == 30);
+      svc_args[0] = ret;
+      break;
+    }
+    case 31: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      queue_t queue = (queue_t)svc_args[0];
+      U32 *msg = (U32 *)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = queueReceive(queue, msg, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 32: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      ringBuffer *ring = (ringBuffer *)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = ringWait(ring, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 33: {
+      event_t *event = (event_t *)svc_args[0];
+      ret = eventCreate(event);
+      svc_args[0] = ret;
+      break;
+    }
+    case 34: {
+      event_t event = (event_t)svc_args[0];
+      U32 mask = (U32)svc_args[1];
+      ret = eventSet(event, mask);
+      svc_args[0] = ret;
+      break;
+    }
+    case 35: {
+      event_t event = (event_t)svc_args[0];
+      U32 mask = (U32)svc_args[1];
+      ret = eventClear(event, mask);
+      svc_args[0] = ret;
+      break;
+    }
+    case 36: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      event_t event = (event_t)svc_args[0];
+      U32 mask = (U32)svc_args[1];
+      U32 mode = (U32)svc_args[2];
+      U32 timeout = (U32)svc_args[3];
+      ret = eventWait(event, mask, mode, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 37: {
+      // Blocks until replied to, ipcReply() rewrites r0 on the task's stack
+      task_t server = (task_t)svc_args[0];
+      ipcMsg *msg = (ipcMsg *)svc_args[1];
+      ret = ipcSend(server, msg);
+      svc_args[0] = ret;
+      break;
+    }
+    case 38: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      task_t *client = (task_t *)svc_args[0];
+      void *buf = (void *)svc_args[1];
+      U32 len = (U32)svc_args[2];
+      U32 timeout = (U32)svc_args[3];
+      ret = ipcReceive(client, buf, len, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 39: {
+      task_t client = (task_t)svc_args[0];
+      const void *reply = (const void *)svc_args[1];
+      U32 len = (U32)svc_args[2];
+      ret = ipcReply(client, reply, len);
+      svc_args[0] = ret;
+      break;
+    }
+    case 40: {
+      task_t tid = (task_t)svc_args[0];
+      ret = yieldTo(tid);
+      svc_args[0] = ret;
+      break;
+    }
+    case 41: {
+      size_t size = (size_t)svc_args[0];
+      void *ptr = mem_alloc_shared(size);
+      svc_args[0] = (unsigned int)ptr;
+      break;
+    }
+    case 42: {
+      void *ptr = (void *)svc_args[0];
+      ret = mem_dealloc_shared(ptr);
+      svc_args[0] = ret;
+      break;
+    }
+    case 43: {
+      topic_t *topic = (topic_t *)svc_args[0];
+      U32 size = (U32)svc_args[1];
+      ret = topicCreate(topic, size);
+      svc_args[0] = ret;
+      break;
+    }
+    case 44: {
+      topic_t topic = (topic_t)svc_args[0];
+      U32 depth = (U32)svc_args[1];
+      subscription_t *sub = (subscription_t *)svc_args[2];
+      ret = subscribe(topic, depth, sub);
+      svc_args[0] = ret;
+      break;
+    }
+    case 45: {
+      topic_t topic = (topic_t)svc_args[0];
+      const void *data = (const void *)svc_args[1];
+      ret = publish(topic, data);
+      svc_args[0] = ret;
+      break;
+    }
+    case 46: {
+      // May block, in which case wakeTask() rewrites r0 on the task's stack
+      subscription_t sub = (subscription_t)svc_args[0];
+      void *buf = (void *)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = topicReceive(sub, buf, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 47: {
+      cond_t *cond = (cond_t *)svc_args[0];
+      ret = condCreate(cond);
+      svc_args[0] = ret;
+      break;
+    }
+    case 48: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      cond_t cond = (cond_t)svc_args[0];
+      mutex_t mutex = (mutex_t)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = condWait(cond, mutex, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 49: {
+      cond_t cond = (cond_t)svc_args[0];
+      ret = condSignal(cond);
+      svc_args[0] = ret;
+      break;
+    }
+    case 50: {
+      cond_t cond = (cond_t)svc_args[0];
+      ret = condBroadcast(cond);
+      svc_args[0] = ret;
+      break;
+    }
+    case 51: {
+      rwLock *lock = (rwLock *)svc_args[0];
+      ret = rwLockCreate(lock);
+      svc_args[0] = ret;
+      break;
+    }
+    case 52: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      U32 id = (U32)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = rwLockRead(id, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 53: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      U32 id = (U32)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = rwLockWrite(id, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 54: {
+      U32 id = (U32)svc_args[0];
+      ret = rwLockUnlock(id);
+      svc_args[0] = ret;
+      break;
+    }
+    case 55: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      task_t tid = (task_t)svc_args[0];
+      int *status = (int *)svc_args[1];
+      U32 timeout = (U32)svc_args[2];
+      ret = taskJoin(tid, status, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 56: {
+      task_t tid = (task_t)svc_args[0];
+      ret = taskDetach(tid);
+      svc_args[0] = ret;
+      break;
+    }
+    case 57: {
+      barrier_t *barrier = (barrier_t *)svc_args[0];
+      U32 parties = (U32)svc_args[1];
+      ret = barrierCreate(barrier, parties);
+      svc_args[0] = ret;
+      break;
+    }
+    case 58: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      barrier_t barrier = (barrier_t)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = barrierWait(barrier, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 59: {
+      group_t *group = (group_t *)svc_args[0];
+      ret = groupCreate(group);
+      svc_args[0] = ret;
+      break;
+    }
+    case 60: {
+      group_t group = (group_t)svc_args[0];
+      TCB *task = (TCB *)svc_args[1];
+      ret = groupSpawn(group, task);
+      svc_args[0] = ret;
+      break;
+    }
+    case 61: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      group_t group = (group_t)svc_args[0];
+      U32 timeout = (U32)svc_args[1];
+      ret = groupWait(group, timeout);
+      svc_args[0] = ret;
+      break;
+    }
+    case 62: {
+      group_t group = (group_t)svc_args[0];
+      ret = groupKill(group);
+      svc_args[0] = ret;
+      break;
+    }
+    case 63: {
+      workq_t *wq = (workq_t *)svc_args[0];
+      U32 workers = (U32)svc_args[1];
+      U16 stack_size = (U16)svc_args[2];
+      ret = workqCreate(wq, workers, stack_size);
+      svc_args[0] = ret;
+      break;
+    }
+    case 64: {
+      workq_t wq = (workq_t)svc_args[0];
+      const workJob *jobs = (const workJob *)svc_args[1];
+      U32 count = (U32)svc_args[2];
+      ret = workqSubmit(wq, jobs, count);
+      svc_args[0] = ret;
+      break;
+    }
+    case 65: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      workJob *job = (workJob *)svc_args[0];
+      ret = workqNext(job);
+      svc_args[0] = ret;
+      break;
+    }
+    case 66: {
+      rtc_t *handler = (rtc_t *)svc_args[0];
+      void (*fn)(void *arg) = (void (*)(void *))svc_args[1];
+      void *arg = (void *)svc_args[2];
+      U32 deadline = (U32)svc_args[3];
+      ret = rtcCreate(handler, fn, arg, deadline);
+      svc_args[0] = ret;
+      break;
+    }
+    case 67: {
+      // Blocks, wakeTask() rewrites r0 on the task's stack
+      workJob *job = (workJob *)svc_args[0];
+      ret = rtcNext(job);
+      svc_args[0] = ret;
+      break;
+    }
+    case 68: {
+      task_t tid = (task_t)svc_args[0];
+      U32 *used = (U32 *)svc_args[1];
+      ret = stackUsage(tid, used);
+      svc_args[0] = ret;
+      break;
+    }
+    case 69: {
+      task_t tid = (task_t)svc_args[0];
+      U32 budget = (U32)svc_args[1];
+      U32 period = (U32)svc_args[2];
+      ret = setReservation(tid, budget, period);
+      svc_args[0] = ret;
+      break;
+    }
+    case 70: {
+      task_t tid = (task_t)svc_args[0];
+      U32 wcet = (U32)svc_args[1];
+      int (*on_overrun)(task_t) = (int (*)(task_t))svc_args[2];
+      ret = setBudget(tid, wcet, on_overrun);
+      svc_args[0] = ret;
+      break;
+    }
+    case 71: {
+      task_t tid = (task_t)svc_args[0];
+      U32 priority = (U32)svc_args[1];
+      ret = setPriority(tid, priority);
+      svc_args[0] = ret;
+      break;
+    }
+    case 72: {
+      task_t tid = (task_t)svc_args[0];
+      U32 cls = (U32)svc_args[1];
+      ret = setClass(tid, cls);
+      svc_args[0] = ret;
+      break;
+    }
+    case 73: {
+      int status = (int)svc_args[0];
+      ret = taskExitCode(status);
+      svc_args[0] = ret;
+      break;
+    }
     default: {
       break;
     }
@@ -23,57 +23,189 @@
 /* Includes */
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
+#include <reent.h>
 
-/**
- * Pointer to the current high watermark of the heap usage
- */
-static uint8_t *__sbrk_heap_end = NULL;
+#include "k_mem.h"
+#include "stm32f401xe.h"
 
 /**
- * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
- *        and others from the C library
+ * @brief _sbrk() would grow a separate newlib heap past the '_end' symbol
  *
  * @verbatim
  * ############################################################################
- * #  .data  #  .bss  #       newlib heap       #          MSP stack          #
- * #         #        #                         # Reserved by _Min_Stack_Size #
+ * #  .data  #  .bss  #        k_mem heap       #          MSP stack          #
+ * #         #        #  (also backs malloc)    # Reserved by _Min_Stack_Size #
  * ############################################################################
  * ^-- RAM start      ^-- _end                             _estack, RAM end --^
  * @endverbatim
  *
- * This implementation starts allocating at the '_end' linker symbol
- * The '_Min_Stack_Size' linker symbol reserves a memory for the MSP stack
- * The implementation considers '_estack' linker symbol to be RAM end
- * NOTE: If the MSP stack, at any point during execution, grows larger than the
- * reserved size, please increase the '_Min_Stack_Size'.
+ * The region after '_end' belongs to the kernel allocator (see mem_init()),
+ * and malloc() and friends below are routed through it, so nothing may move
+ * the break. Any stray caller gets ENOMEM instead of a second pool.
  *
  * @param incr Memory size
- * @return Pointer to allocated memory
+ * @return (void *)-1 with errno set to ENOMEM
  */
 void *_sbrk(ptrdiff_t incr)
 {
-  extern uint8_t _end; /* Symbol defined in the linker script */
-  extern uint8_t _estack; /* Symbol defined in the linker script */
-  extern uint32_t _Min_Stack_Size; /* Symbol defined in the linker script */
-  const uint32_t stack_limit = (uint32_t)&_estack - (uint32_t)&_Min_Stack_Size;
-  const uint8_t *max_heap = (uint8_t *)stack_limit;
-  uint8_t *prev_heap_end;
-
-  /* Initialize heap end at first call */
-  if (NULL == __sbrk_heap_end)
+  (void)incr;
+  errno = ENOMEM;
+  return (void *)-1;
+}
+
+/**
+ * @brief Check whether the kernel heap must be entered directly
+ *
+ * From thread mode requests go through the SVC, which serializes them
+ * against every other kernel call. In handler mode we are already inside
+ * the kernel, and with interrupts masked an SVC would escalate to a
+ * HardFault, so the allocator is called directly instead.
+ */
+static int heap_direct(void)
+{
+  return __get_IPSR() != 0 || __get_PRIMASK() != 0;
+}
+
+/**
+ * @brief Allocate from the kernel heap on behalf of the C library
+ */
+static void *heap_alloc(size_t size)
+{
+  void *ptr;
+
+  if (!heap_direct())
+  {
+    ptr = k_mem_alloc(size);
+  }
+  else
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ptr = mem_alloc(size);
+    __set_PRIMASK(primask);
+  }
+
+  if (ptr == NULL)
+  {
+    errno = ENOMEM;
+  }
+  return ptr;
+}
+
+/**
+ * @brief Return a block obtained through heap_alloc() to the kernel heap
+ *
+ * As with k_mem_dealloc(), only the task that allocated a block may free
+ * it; a block freed by any other task is left allocated.
+ */
+static void heap_free(void *ptr)
+{
+  if (ptr == NULL)
   {
-    __sbrk_heap_end = &_end;
+    return;
   }
 
-  /* Protect heap from growing into the reserved MSP stack */
-  if (__sbrk_heap_end + incr > max_heap)
+  if (!heap_direct())
+  {
+    k_mem_dealloc(ptr);
+  }
+  else
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    mem_dealloc(ptr);
+    __set_PRIMASK(primask);
+  }
+}
+
+/**
+ * @brief newlib allocator entry points
+ *
+ * newlib calls the reentrant _r variants internally (e.g. when printf sets
+ * up the stdout buffer), so both forms are provided to keep the library's
+ * own allocator and _sbrk() from being linked in. Allocations made before
+ * k_mem_init() fail with ENOMEM, which newlib handles by leaving the stream
+ * unbuffered.
+ */
+void *_malloc_r(struct _reent *r, size_t size)
+{
+  (void)r;
+  return heap_alloc(size);
+}
+
+void _free_r(struct _reent *r, void *ptr)
+{
+  (void)r;
+  heap_free(ptr);
+}
+
+void *_calloc_r(struct _reent *r, size_t n, size_t size)
+{
+  (void)r;
+  if (size != 0 && n > SIZE_MAX / size)
   {
     errno = ENOMEM;
-    return (void *)-1;
+    return NULL;
+  }
+
+  void *ptr = heap_alloc(n * size);
+  if (ptr != NULL)
+  {
+    memset(ptr, 0, n * size);
+  }
+  return ptr;
+}
+
+void *_realloc_r(struct _reent *r, void *ptr, size_t size)
+{
+  (void)r;
+  if (ptr == NULL)
+  {
+    return heap_alloc(size);
+  }
+  if (size == 0)
+  {
+    heap_free(ptr);
+    return NULL;
   }
 
-  prev_heap_end = __sbrk_heap_end;
-  __sbrk_heap_end += incr;
+  size_t old_size = mem_size(ptr);
+  if (old_size == 0)
+  {
+    errno = EINVAL;
+    return NULL;
+  }
+  if (old_size >= size)
+  {
+    return ptr;
+  }
+
+  void *new_ptr = heap_alloc(size);
+  if (new_ptr != NULL)
+  {
+    memcpy(new_ptr, ptr, old_size);
+    heap_free(ptr);
+  }
+  return new_ptr;
+}
+
+void *malloc(size_t size)
+{
+  return _malloc_r(_REENT, size);
+}
+
+void free(void *ptr)
+{
+  _free_r(_REENT, ptr);
+}
 
-  return (void *)prev_heap_end;
+void *calloc(size_t n, size_t size)
+{
+  return _calloc_r(_REENT, n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  return _realloc_r(_REENT, ptr, size);
 }
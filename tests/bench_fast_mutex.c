@@ -0,0 +1,73 @@
+/*
+ * bench_fast_mutex.c
+ *
+ *  Cycles per uncontended lock/unlock pair for the fast mutex against the
+ *  kernel mutex, which traps on every call. Under contention the fast
+ *  mutex enters the kernel once to sleep and once to wake.
+ */
+
+#include "sim.h"
+#include "k_sync.h"
+
+#define PAIRS 100000 // lock/unlock pairs timed for each kind
+
+int main(void) {
+    simInit();
+    task_t low = simSpawn(100);
+    task_t high = simSpawn(20);
+    static fastMutex fast;
+    static mutex_t lock;
+    static semaphore_t go_high;
+    osFastMutexInit(&fast);
+    CHECK(mutexCreate(&lock) == RTX_OK);
+    CHECK(semCreate(&go_high, 0) == RTX_OK);
+    simStart();
+    CHECK(running_task == high);
+
+    U32 traps = sim_traps;
+    uint64_t start = simCycles();
+    for (int i = 0; i < PAIRS; i++) {
+        osFastMutexLock(&fast, OS_WAIT_FOREVER);
+        osFastMutexUnlock(&fast);
+    }
+    uint64_t fast_cycles = simCycles() - start;
+    U32 fast_traps = sim_traps - traps;
+
+    traps = sim_traps;
+    start = simCycles();
+    for (int i = 0; i < PAIRS; i++) {
+        osMutexLock(lock, OS_WAIT_FOREVER);
+        osMutexUnlock(lock);
+    }
+    uint64_t trap_cycles = simCycles() - start;
+    U32 trap_traps = sim_traps - traps;
+
+    printf("fast mutex:   %6.1f cycles/pair, %.1f kernel entries/pair\n",
+           (double)fast_cycles / PAIRS, (double)fast_traps / PAIRS);
+    printf("kernel mutex: %6.1f cycles/pair, %.1f kernel entries/pair\n",
+           (double)trap_cycles / PAIRS, (double)trap_traps / PAIRS);
+    CHECK(fast_traps == 0);
+    CHECK(trap_traps == 2 * PAIRS);
+
+    // H sleeps so L can take the fast mutex, then wakes and finds it held
+    simArgs(go_high, OS_WAIT_FOREVER, 0, 0);
+    simReturn(semWait(go_high, OS_WAIT_FOREVER));
+    simSwitch();
+    CHECK(running_task == low);
+    CHECK(osFastMutexLock(&fast, OS_WAIT_FOREVER) == RTX_OK);
+    simArgs(go_high, 0, 0, 0);
+    simReturn(semPost(go_high));
+    simSwitch();
+    CHECK(running_task == high);
+
+    traps = sim_traps;
+    osFastMutexLock(&fast, OS_WAIT_FOREVER);
+    CHECK(tasks[high].state == BLOCKED);
+    CHECK(running_task == low);
+    CHECK(osFastMutexUnlock(&fast) == RTX_OK);
+    CHECK(running_task == high);
+    CHECK(simResult(high) == RTX_OK);
+    printf("contended:    %u kernel entries to sleep and wake\n", sim_traps - traps);
+    CHECK(sim_traps - traps == 2);
+    return 0;
+}
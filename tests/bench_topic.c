@@ -0,0 +1,80 @@
+/*
+ * bench_topic.c
+ *
+ *  One publisher fanning samples out to eight subscribers that are
+ *  blocked in osTopicReceive() each time it publishes. Checks every
+ *  subscriber gets every sample in order and reports the host cycles
+ *  spent per publish and per delivered sample, including the switches to
+ *  and from each subscriber.
+ */
+
+#include <string.h>
+
+#include "sim.h"
+#include "k_msg.h"
+
+#define SUBSCRIBERS 8
+#define SAMPLES     20000 // samples published
+#define SAMPLE_SIZE 32 // bytes in a sample, the first word is its number
+
+static U32 buffers[SUBSCRIBERS][SAMPLE_SIZE / 4]; // each subscriber's receive buffer
+
+static void receive(subscription_t sub, int index) {
+    simArgs(sub, (U32)(uintptr_t)buffers[index], OS_WAIT_FOREVER, 0);
+    simReturn(topicReceive(sub, buffers[index], OS_WAIT_FOREVER));
+    simSwitch();
+}
+
+int main(void) {
+    simInit();
+    task_t publisher = simSpawn(20);
+    task_t subscriber[SUBSCRIBERS];
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        subscriber[i] = simSpawn(10);
+    }
+    static topic_t topic;
+    static subscription_t subs[SUBSCRIBERS];
+    CHECK(topicCreate(&topic, SAMPLE_SIZE) == RTX_OK);
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        CHECK(subscribe(topic, 4, &subs[i]) == RTX_OK);
+    }
+    simStart();
+
+    // Every subscriber waits for the first sample
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        CHECK(running_task == subscriber[i]);
+        receive(subs[i], i);
+    }
+    CHECK(running_task == publisher);
+
+    static U32 sample[SAMPLE_SIZE / 4];
+    U32 received[SUBSCRIBERS] = {0};
+    uint64_t start = simCycles();
+    for (U32 n = 1; n <= SAMPLES; n++) {
+        sample[0] = n;
+        simArgs(topic, (U32)(uintptr_t)sample, 0, 0);
+        simReturn(publish(topic, sample));
+        simSwitch();
+
+        // Each subscriber preempts the publisher in turn, takes the sample
+        // and goes back to waiting for the next
+        while (running_task != publisher) {
+            int i = 0;
+            while (subscriber[i] != running_task) {
+                i++;
+            }
+            CHECK(simResult(running_task) == RTX_OK);
+            CHECK(buffers[i][0] == n);
+            received[i]++;
+            receive(subs[i], i);
+        }
+    }
+    uint64_t cycles = simCycles() - start;
+
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        CHECK(received[i] == SAMPLES);
+    }
+    printf("%d subscribers: %.0f cycles per publish, %.0f cycles per delivered sample\n",
+           SUBSCRIBERS, (double)cycles / SAMPLES, (double)cycles / (SAMPLES * SUBSCRIBERS));
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * bench_yield_to.c
+ *
+ *  A four-stage pipeline whose stages each work for 1 ms and then pass
+ *  control on, sharing the CPU with four unrelated tasks of the same
+ *  deadline. Compares handing off with osYieldTo() against plain
+ *  osYield(): how long a stage waits after the previous one finishes, and
+ *  the host cycles the kernel spends per handoff.
+ */
+
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define STAGES   4 // pipeline tasks, each handing off to the next
+#define OTHERS   4 // unrelated tasks that just work and yield
+#define DEADLINE 40 // ms, the same for every task
+#define STEPS    20000 // 1 ms steps simulated
+
+typedef struct {
+    U32 handoffs; // times a stage finished
+    U32 waited; // ms between a stage finishing and the next one starting
+    uint64_t cycles; // spent in yield/yieldTo and the switch that follows
+} pipelineStats;
+
+static void run(int use_yield_to, pipelineStats *stats) {
+    simInit();
+    task_t stage[STAGES];
+    for (int i = 0; i < OTHERS; i++) {
+        simSpawn(DEADLINE);
+    }
+    for (int i = 0; i < STAGES; i++) {
+        stage[i] = simSpawn(DEADLINE);
+    }
+    simStart();
+
+    memset(stats, 0, sizeof(*stats));
+    int waiting = -1; // stage due to run next, -1 before the first handoff
+    U32 finished_at = 0;
+    for (U32 step = 0; step < STEPS; step++) {
+        int current = -1;
+        for (int i = 0; i < STAGES; i++) {
+            if (stage[i] == running_task) {
+                current = i;
+            }
+        }
+        if (current >= 0 && current == waiting) {
+            stats->waited += sim_tick - finished_at;
+            waiting = -1;
+        }
+
+        // The running task works for 1 ms, then gives up the CPU
+        simTick();
+        uint64_t start = simCycles();
+        if (current >= 0 && use_yield_to) {
+            yieldTo(stage[(current + 1) % STAGES]);
+        } else {
+            yield();
+        }
+        simSwitch();
+        stats->cycles += simCycles() - start;
+
+        if (current >= 0) {
+            stats->handoffs++;
+            waiting = (current + 1) % STAGES;
+            finished_at = sim_tick;
+        }
+    }
+}
+
+int main(void) {
+    pipelineStats stats[2];
+    for (int use_yield_to = 0; use_yield_to < 2; use_yield_to++) {
+        // The kernel can only be brought up once per process
+        int fds[2];
+        CHECK(pipe(fds) == 0);
+        pid_t child = fork();
+        CHECK(child >= 0);
+        if (child == 0) {
+            run(use_yield_to, &stats[use_yield_to]);
+            CHECK(write(fds[1], &stats[use_yield_to], sizeof(pipelineStats)) == sizeof(pipelineStats));
+            exit(0);
+        }
+        int status;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK(read(fds[0], &stats[use_yield_to], sizeof(pipelineStats)) == sizeof(pipelineStats));
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    const char *names[2] = {"osYield  ", "osYieldTo"};
+    for (int i = 0; i < 2; i++) {
+        printf("%s: %u handoffs, %.2f ms until the next stage runs, %.0f cycles per switch\n",
+               names[i], stats[i].handoffs, (double)stats[i].waited / stats[i].handoffs,
+               (double)stats[i].cycles / STEPS);
+    }
+    CHECK(stats[1].handoffs > 0 && stats[0].handoffs > 0);
+    CHECK(stats[1].waited * stats[0].handoffs < stats[0].waited * stats[1].handoffs);
+    return 0;
+}
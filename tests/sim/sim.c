@@ -0,0 +1,229 @@
+/*
+ * sim.c
+ *
+ *  Host implementation of the core registers, intrinsics and HAL tick the
+ *  kernel uses, plus the harness described in sim.h. LDREX/STREX are
+ *  emulated with a per-thread reservation and a compare-and-swap, which is
+ *  enough for the single-word protocols in the kernel library.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <x86intrin.h>
+
+#include "sim.h"
+#include "stm32f401xe.h"
+#include "stm32f4xx_hal.h"
+#include "k_workq.h"
+#include "k_rtc.h"
+#include "k_sync.h"
+
+SCB_Type sim_scb;
+DWT_Type sim_dwt;
+CoreDebug_Type sim_core_debug;
+uint32_t SystemCoreClock = 84000000;
+
+U32 sim_tick;
+U32 sim_traps;
+U32 sim_frames[MAX_TASKS][8];
+
+// Initial MSP and vector table; the linker places the heap in sim_heap
+static U32 sim_msp_stack[(MAIN_STACK_SIZE + THREAD_STACK_SIZE) / 4];
+static U32 sim_vectors[1];
+U32 sim_heap[SIM_HEAP_SIZE / 4] __attribute__((aligned(8)));
+
+static U32 sim_primask;
+
+static __thread volatile void *exclusive_addr; // address reserved by the last LDREX
+static __thread U32 exclusive_value; // value it held then
+
+uint32_t __get_PSP(void) {
+    // Blocking calls record the frame their arguments were stacked in
+    return (uint32_t)(uintptr_t)sim_frames[running_task];
+}
+
+void __set_PSP(uint32_t psp) {
+    (void)psp;
+}
+
+uint32_t __get_IPSR(void) {
+    return 0;
+}
+
+uint32_t __get_PRIMASK(void) {
+    return sim_primask;
+}
+
+void __set_PRIMASK(uint32_t primask) {
+    sim_primask = primask;
+}
+
+void __disable_irq(void) {
+    sim_primask = 1;
+}
+
+void __enable_irq(void) {
+    sim_primask = 0;
+}
+
+uint8_t __CLZ(uint32_t value) {
+    return (value == 0) ? 32 : (uint8_t)__builtin_clz(value);
+}
+
+void __DMB(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void __CLREX(void) {
+    exclusive_addr = NULL;
+}
+
+uint32_t __LDREXW(volatile uint32_t *addr) {
+    U32 value = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+    exclusive_addr = addr;
+    exclusive_value = value;
+    return value;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) {
+    if (exclusive_addr != addr) {
+        return 1;
+    }
+    exclusive_addr = NULL;
+    U32 expected = exclusive_value;
+    return __atomic_compare_exchange_n(addr, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 0 : 1;
+}
+
+uint16_t __LDREXH(volatile uint16_t *addr) {
+    uint16_t value = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+    exclusive_addr = addr;
+    exclusive_value = value;
+    return value;
+}
+
+uint32_t __STREXH(uint16_t value, volatile uint16_t *addr) {
+    if (exclusive_addr != addr) {
+        return 1;
+    }
+    exclusive_addr = NULL;
+    uint16_t expected = (uint16_t)exclusive_value;
+    return __atomic_compare_exchange_n(addr, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void) {
+    return sim_tick;
+}
+
+void HAL_IncTick(void) {
+    sim_tick++;
+}
+
+void HAL_ResumeTick(void) {
+}
+
+// Workers and the run-to-completion dispatcher never run on the host
+int osWorkqNext(workJob *job) {
+    return workqNext(job);
+}
+
+int osRtcNext(workJob *job) {
+    return rtcNext(job);
+}
+
+// SVC wrappers the user-side libraries call, each counted as a kernel entry.
+// A host system call stands in for the exception entry and return, so the
+// timed cost of a trap includes a real privilege switch
+static int trap(int ret) {
+    sim_traps++;
+    syscall(SYS_getppid);
+    simReturn(ret);
+    simSwitch();
+    return ret;
+}
+
+int osFutexWait(volatile U32 *addr, U32 expected, U32 timeout) {
+    simArgs((U32)(uintptr_t)addr, expected, timeout, 0);
+    return trap(futexWait(addr, expected, timeout));
+}
+
+int osFutexWake(volatile U32 *addr, U32 count) {
+    simArgs((U32)(uintptr_t)addr, count, 0, 0);
+    return trap(futexWake(addr, count));
+}
+
+int osMutexLock(mutex_t mutex, U32 timeout) {
+    simArgs(mutex, timeout, 0, 0);
+    return trap(mutexLock(mutex, timeout));
+}
+
+int osMutexUnlock(mutex_t mutex) {
+    simArgs(mutex, 0, 0, 0);
+    return trap(mutexUnlock(mutex));
+}
+
+void simInit(void) {
+    sim_vectors[0] = (U32)(uintptr_t)&sim_msp_stack[sizeof(sim_msp_stack) / 4];
+    sim_scb.VTOR = (U32)(uintptr_t)sim_vectors;
+    kernelInit();
+    CHECK(mem_init() == RTX_OK);
+}
+
+task_t simSpawn(U32 deadline) {
+    TCB task;
+    memset(&task, 0, sizeof(task));
+    task.ptask = NULL;
+    task.stack_size = STACK_SIZE;
+    CHECK(createTask(&task) == RTX_OK);
+    if (deadline != DEFAULT_DEADLINE) {
+        CHECK(setDeadline((int)deadline, task.tid) == RTX_OK);
+    }
+    return task.tid;
+}
+
+void simStart(void) {
+    CHECK(startKernel() == RTX_OK);
+    simSwitch();
+}
+
+int simSwitch(void) {
+    if (!(sim_scb.ICSR & SCB_ICSR_PENDSVSET_Msk)) {
+        return 0;
+    }
+    sim_scb.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+    change_task();
+    return 1;
+}
+
+void simTick(void) {
+    // What SysTick_Handler() does
+    HAL_IncTick();
+    deadlineTick();
+    timeoutTick();
+    scheduler();
+    if (selected_task != running_task) {
+        sim_scb.ICSR |= SCB_ICSR_PENDSVSET_Msk;
+    }
+    simSwitch();
+}
+
+void simArgs(U32 a0, U32 a1, U32 a2, U32 a3) {
+    U32 *frame = sim_frames[running_task];
+    frame[0] = a0;
+    frame[1] = a1;
+    frame[2] = a2;
+    frame[3] = a3;
+}
+
+int simReturn(int ret) {
+    sim_frames[running_task][0] = (U32)ret;
+    return ret;
+}
+
+int simResult(task_t tid) {
+    return (int)sim_frames[tid][0];
+}
+
+uint64_t simCycles(void) {
+    return __rdtsc();
+}
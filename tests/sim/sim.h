@@ -0,0 +1,60 @@
+/*
+ * sim.h
+ *
+ *  Host harness for the kernel. The kernel sources are built unchanged
+ *  against the CMSIS stand-ins in tests/stubs; the harness plays the part
+ *  of the hardware. A test acts as whichever task is running: it stacks
+ *  the arguments of the "SVC" it is about to make with simArgs(), calls
+ *  the kernel-side function the dispatcher would, and lets simSwitch()
+ *  run PendSV and simTick() run SysTick.
+ */
+
+#ifndef TESTS_SIM_H_
+#define TESTS_SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+#define SIM_HEAP_SIZE 0x10000 // bytes of kernel heap, linked in as _end.._estack
+
+extern TCB tasks[MAX_TASKS];
+extern kernelTCB ktasks[MAX_TASKS];
+extern task_t running_task;
+extern task_t selected_task;
+extern U32 sim_tick; // value HAL_GetTick() returns
+extern U32 sim_traps; // SVCs made through the os* wrappers sim.c provides
+extern U32 sim_frames[MAX_TASKS][8]; // exception frame of each task's last SVC
+
+// Bring up the kernel and its heap, as main() does
+void simInit(void);
+// Create a task with the given deadline (ms), returning its TID
+task_t simSpawn(U32 deadline);
+// Start the kernel and switch to the first task
+void simStart(void);
+// Run PendSV if it is pending, returns 1 if it was
+int simSwitch(void);
+// Advance time by one ms, running SysTick and then any PendSV it pends
+void simTick(void);
+// Stack the running task's SVC arguments, as the exception entry would
+void simArgs(U32 a0, U32 a1, U32 a2, U32 a3);
+// Store an SVC's return value in r0 of the running task, as the dispatcher does
+int simReturn(int ret);
+// r0 of a task's last SVC: its result once a blocking call completes
+int simResult(task_t tid);
+// Cycle counter of the host CPU, for benchmarks
+uint64_t simCycles(void);
+
+// Fail the test with a message if cond is false
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#endif /* TESTS_SIM_H_ */
@@ -0,0 +1,56 @@
+/*
+ * stm32f401xe.h
+ *
+ *  Host stand-in for the CMSIS device header. Provides just the core
+ *  registers and intrinsics the kernel uses, backed by tests/sim/sim.c.
+ */
+
+#ifndef HOST_STM32F401XE_H_
+#define HOST_STM32F401XE_H_
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t ICSR;
+    volatile uint32_t VTOR;
+} SCB_Type;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern SCB_Type sim_scb;
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_core_debug;
+extern uint32_t SystemCoreClock; // Hz, as system_stm32f4xx.c keeps it
+
+#define SCB       (&sim_scb)
+#define DWT       (&sim_dwt)
+#define CoreDebug (&sim_core_debug)
+
+#define SCB_ICSR_PENDSVSET_Msk     (1UL << 28)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+uint32_t __get_PSP(void);
+void __set_PSP(uint32_t psp);
+uint32_t __get_IPSR(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+uint8_t __CLZ(uint32_t value);
+void __DMB(void);
+void __CLREX(void);
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+uint16_t __LDREXH(volatile uint16_t *addr);
+uint32_t __STREXH(uint16_t value, volatile uint16_t *addr);
+
+#endif /* HOST_STM32F401XE_H_ */
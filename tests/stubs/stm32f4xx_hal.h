@@ -0,0 +1,16 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Host stand-in for the HAL: only the tick functions the kernel calls.
+ */
+
+#ifndef HOST_STM32F4XX_HAL_H_
+#define HOST_STM32F4XX_HAL_H_
+
+#include "stm32f401xe.h"
+
+uint32_t HAL_GetTick(void);
+void HAL_IncTick(void);
+void HAL_ResumeTick(void);
+
+#endif /* HOST_STM32F4XX_HAL_H_ */
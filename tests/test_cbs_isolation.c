@@ -0,0 +1,105 @@
+/*
+ * test_cbs_isolation.c
+ *
+ *  A hog task that never gives up the CPU shares it with a periodic task
+ *  needing 4 ms of every 10. Unreserved, the hog's short deadline keeps
+ *  coming round before the periodic task's, which then misses its
+ *  deadlines. Run as a CBS with 3 ms every 10 ms, the hog can only delay
+ *  itself: the periodic task meets all its deadlines and the hog still
+ *  gets its reserved share plus whatever the periodic task leaves idle.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "k_sync.h"
+
+#define PERIOD   10 // ms between releases of the periodic task, also its deadline
+#define WORK     4 // ms of CPU the periodic task needs each period
+#define BUDGET   3 // ms of CPU reserved for the hog each PERIOD
+#define HOG_DEADLINE 2 // ms, the unreserved hog's deadline
+#define PERIODS  1000 // periods simulated
+
+typedef struct {
+    U32 misses; // periodic jobs not finished by the next release
+    U32 hog_ms; // ms the hog ran
+} cbsStats;
+
+static void run(int reserved, cbsStats *stats) {
+    simInit();
+    task_t periodic = simSpawn(PERIOD);
+    task_t hog = simSpawn(reserved ? PERIOD : HOG_DEADLINE);
+    static semaphore_t release;
+    CHECK(semCreate(&release, 0) == RTX_OK);
+    if (reserved) {
+        CHECK(setReservation(hog, BUDGET, PERIOD) == RTX_OK);
+    }
+    simStart();
+
+    stats->misses = 0;
+    stats->hog_ms = 0;
+    U32 remaining = 0; // ms of work left in the periodic task's current job
+    for (U32 ms = 0; ms < PERIODS * PERIOD; ms++) {
+        if (ms % PERIOD == 0) {
+            // Timer interrupt releasing the next job, due in PERIOD ms
+            if (remaining > 0) {
+                stats->misses++;
+            }
+            remaining = WORK;
+            if (tasks[periodic].state == BLOCKED) {
+                semPost(release);
+            }
+            if (periodic != running_task) {
+                setDeadline(PERIOD, periodic);
+            }
+            simSwitch();
+        }
+
+        if (running_task == periodic && remaining == 0) {
+            // Job done, wait for the next release
+            simArgs(release, OS_WAIT_FOREVER, 0, 0);
+            simReturn(semWait(release, OS_WAIT_FOREVER));
+            simSwitch();
+        }
+
+        // Whichever task is running now gets this ms
+        if (running_task == periodic) {
+            remaining--;
+        } else if (running_task == hog) {
+            stats->hog_ms++;
+        }
+        simTick();
+    }
+}
+
+int main(void) {
+    cbsStats stats[2];
+    for (int reserved = 0; reserved < 2; reserved++) {
+        // The kernel can only be brought up once per process
+        int fds[2];
+        CHECK(pipe(fds) == 0);
+        pid_t child = fork();
+        CHECK(child >= 0);
+        if (child == 0) {
+            run(reserved, &stats[reserved]);
+            CHECK(write(fds[1], &stats[reserved], sizeof(cbsStats)) == sizeof(cbsStats));
+            exit(0);
+        }
+        int status;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK(read(fds[0], &stats[reserved], sizeof(cbsStats)) == sizeof(cbsStats));
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    const char *names[2] = {"unreserved hog", "hog as CBS    "};
+    for (int i = 0; i < 2; i++) {
+        printf("%s: periodic task missed %u of %d deadlines, hog ran %.1f%% of the time\n",
+               names[i], stats[i].misses, PERIODS, 100.0 * stats[i].hog_ms / (PERIODS * PERIOD));
+    }
+    CHECK(stats[0].misses > PERIODS / 2);
+    CHECK(stats[1].misses == 0);
+    CHECK(stats[1].hog_ms >= PERIODS * BUDGET);
+    return 0;
+}
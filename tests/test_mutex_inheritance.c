@@ -0,0 +1,81 @@
+/*
+ * test_mutex_inheritance.c
+ *
+ *  Classic priority inversion under EDF: a late task L holds a mutex the
+ *  urgent task H needs, while a medium task M is ready. Without inheritance
+ *  M runs ahead of L and so delays H; with it L runs on H's deadline until
+ *  it unlocks, and keeps doing so as time passes.
+ */
+
+#include "sim.h"
+#include "k_sync.h"
+
+static void call(int ret) {
+    simReturn(ret);
+    simSwitch();
+}
+
+int main(void) {
+    simInit();
+    task_t low = simSpawn(100);
+    task_t high = simSpawn(20);
+    task_t medium = simSpawn(40);
+    static semaphore_t go_high, go_medium;
+    static mutex_t lock;
+    CHECK(semCreate(&go_high, 0) == RTX_OK);
+    CHECK(semCreate(&go_medium, 0) == RTX_OK);
+    CHECK(mutexCreate(&lock) == RTX_OK);
+    simStart();
+
+    // H and M wait to be released, leaving L to take the lock
+    CHECK(running_task == high);
+    call(semWait(go_high, OS_WAIT_FOREVER));
+    CHECK(running_task == medium);
+    call(semWait(go_medium, OS_WAIT_FOREVER));
+    CHECK(running_task == low);
+    call(mutexLock(lock, OS_WAIT_FOREVER));
+    CHECK(simResult(low) == RTX_OK);
+
+    // H wakes, preempts L and blocks on the lock L holds
+    call(semPost(go_high));
+    CHECK(running_task == high);
+    call(mutexLock(lock, OS_WAIT_FOREVER));
+    CHECK(tasks[high].state == BLOCKED);
+    CHECK(running_task == low);
+
+    // M becomes ready. Its deadline is earlier than L's own, so without
+    // inheritance it would preempt L and H would wait for both
+    call(semPost(go_medium));
+    CHECK(tasks[medium].state == READY);
+    CHECK(tasks[low].time_left > taskKey(medium));
+    CHECK(running_task == low);
+    CHECK(taskKey(low) == taskKey(high));
+
+    // The inherited deadline ages with H's, so the boost neither wears off
+    // nor jumps back when the waiters are looked at again
+    for (int i = 0; i < 10; i++) {
+        simTick();
+        CHECK(running_task == low);
+        CHECK(taskKey(low) == taskKey(high));
+    }
+    CHECK(taskKey(high) == 10);
+    static mutex_t other;
+    CHECK(mutexCreate(&other) == RTX_OK);
+    call(mutexLock(other, OS_WAIT_FOREVER));
+    call(mutexUnlock(other));
+    CHECK(running_task == low);
+    CHECK(taskKey(low) == taskKey(high));
+
+    // Unlocking hands the mutex to H, which runs at once; L drops back
+    call(mutexUnlock(lock));
+    CHECK(running_task == high);
+    CHECK(simResult(high) == RTX_OK);
+    CHECK(taskKey(low) == tasks[low].time_left);
+    CHECK(ktasks[low].inherit_left == 0);
+
+    // Once H is done, M goes before L as plain EDF says
+    call(mutexUnlock(lock));
+    call(semWait(go_high, OS_WAIT_FOREVER));
+    CHECK(running_task == medium);
+    return 0;
+}
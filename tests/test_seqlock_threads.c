@@ -0,0 +1,111 @@
+/*
+ * test_seqlock_threads.c
+ *
+ *  A writer thread keeps rewriting a large record, every word of which
+ *  holds the same sequence number, while a reader thread reads it through
+ *  the seqlock and then the triple buffer. A read that mixes words from
+ *  two writes, or goes back to an older record, fails the test.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "sim.h"
+#include "k_seqlock.h"
+
+#define WORDS 1024 // words in the record, large so writes are often interrupted
+#define READS 20000 // reads made through each primitive
+
+static seqlock lock;
+static U32 shared[WORDS];
+static tripleBuffer triple;
+static U32 triple_storage[3 * WORDS];
+static volatile int stop;
+
+static void fill(U32 *record, U32 n) {
+    for (int i = 0; i < WORDS; i++) {
+        record[i] = n;
+    }
+}
+
+static void check(const U32 *record, U32 *last) {
+    for (int i = 1; i < WORDS; i++) {
+        if (record[i] != record[0]) {
+            fprintf(stderr, "torn read: word 0 is %u, word %d is %u\n", record[0], i, record[i]);
+            exit(1);
+        }
+    }
+    CHECK(record[0] >= *last);
+    *last = record[0];
+}
+
+static void *seqlockWriter(void *arg) {
+    (void)arg;
+    static U32 record[WORDS];
+    for (U32 n = 1; !stop; n++) {
+        fill(record, n);
+        osSeqlockWrite(&lock, shared, record, sizeof(record));
+    }
+    return NULL;
+}
+
+static void *tripleWriter(void *arg) {
+    (void)arg;
+    for (U32 n = 1; !stop; n++) {
+        fill(osTripleWriteBuffer(&triple), n);
+        osTriplePublish(&triple);
+        if (n % 16 == 0) {
+            // Give the reader a turn, even on one CPU
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    osSeqlockInit(&lock);
+    CHECK(osTripleInit(&triple, (U8 *)triple_storage, sizeof(shared)) == RTX_OK);
+
+    // Seqlock: count the reads that overlapped a write and had to copy again
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, seqlockWriter, NULL) == 0);
+    static U32 copy[WORDS];
+    U32 last = 0;
+    U32 retries = 0;
+    for (int r = 0; r < READS; r++) {
+        for (;;) {
+            U32 start = osSeqlockReadBegin(&lock);
+            memcpy(copy, shared, sizeof(copy));
+            if (!osSeqlockReadRetry(&lock, start)) {
+                break;
+            }
+            retries++;
+        }
+        check(copy, &last);
+    }
+    stop = 1;
+    CHECK(pthread_join(thread, NULL) == 0);
+    printf("seqlock: %d reads, %u retried, last record %u\n", READS, retries, last);
+
+    // Triple buffer: the reader's buffer is never written while it holds it
+    stop = 0;
+    CHECK(pthread_create(&thread, NULL, tripleWriter, NULL) == 0);
+    last = 0;
+    U32 fresh_reads = 0;
+    for (int r = 0; r < READS; r++) {
+        int fresh;
+        const U32 *record = osTripleRead(&triple, &fresh);
+        check(record, &last);
+        if (fresh) {
+            fresh_reads++;
+        } else {
+            // Let the writer publish something new, even on one CPU
+            sched_yield();
+        }
+    }
+    stop = 1;
+    CHECK(pthread_join(thread, NULL) == 0);
+    printf("triple buffer: %d reads, %u fresh, last record %u\n", READS, fresh_reads, last);
+    return 0;
+}
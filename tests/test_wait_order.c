@@ -0,0 +1,43 @@
+/*
+ * test_wait_order.c
+ *
+ *  Tasks that block on a semaphore at different times must wake in order
+ *  of their current deadlines, not of the time left when they blocked.
+ */
+
+#include "sim.h"
+#include "k_sync.h"
+
+int main(void) {
+    simInit();
+    task_t early = simSpawn(30);
+    task_t late = simSpawn(50);
+    task_t poster = simSpawn(200);
+    static semaphore_t sem;
+    CHECK(semCreate(&sem, 0) == RTX_OK);
+    simStart();
+
+    // The earliest task blocks straight away, due in 30 ms
+    CHECK(running_task == early);
+    simArgs(sem, OS_WAIT_FOREVER, 0, 0);
+    simReturn(semWait(sem, OS_WAIT_FOREVER));
+    simSwitch();
+
+    // 25 ms later the other blocks with 25 ms left, while the first is due in 5
+    CHECK(running_task == late);
+    for (int i = 0; i < 25; i++) {
+        simTick();
+    }
+    CHECK(running_task == late);
+    simArgs(sem, OS_WAIT_FOREVER, 0, 0);
+    simReturn(semWait(sem, OS_WAIT_FOREVER));
+    simSwitch();
+    CHECK(running_task == poster);
+    CHECK(taskKey(early) < taskKey(late));
+
+    CHECK(semPost(sem) == RTX_OK);
+    CHECK(tasks[early].state == READY);
+    CHECK(tasks[late].state == BLOCKED);
+    CHECK(simResult(early) == RTX_OK);
+    return 0;
+}